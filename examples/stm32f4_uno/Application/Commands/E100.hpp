@@ -114,6 +114,7 @@ public:
 
 
     runReturn runErase() {
+        if (S > 0) return runEraseRange();
         out()->printf("SECTOR_ADDRESS: 0x%08x\r\n", A);
         auto ret = sst26.WREN();
         ret = ret != HalStatus::HAL_OK ? ret : sst26.SE(A);
@@ -124,6 +125,17 @@ public:
     }
 
 
+    runReturn runEraseRange() {
+        out()->printf("START_ADDRESS: 0x%08x\r\n", A);
+        out()->printf("SIZE: %d\r\n", S);
+        const uint32_t start = millis();
+        const auto ret = sst26.eraseRange(A, S);
+        out()->printf("TIME_MS: %lu\r\n", millis() - start);
+
+        return ret == LX_SUCCESS ? runReturn::FINISHED : runReturn::ERROR;
+    }
+
+
     runReturn runChipErase() {
         auto ret = sst26.WREN();
         ret = ret != HalStatus::HAL_OK ? ret : sst26.CE();
@@ -134,6 +146,66 @@ public:
     }
 
 
+    runReturn runInfo() {
+        const auto &sfdp = sst26.getSfdp();
+        out()->printf("SFDP: %d\r\n", sfdp.isValid());
+        out()->printf("DENSITY: %lu\r\n", sfdp.getDensity());
+        out()->printf("PAGE_SIZE: %lu\r\n", sfdp.getPageSize());
+        for (uint8_t i = 0; i < 4; i++) {
+            const auto eraseType = sfdp.getEraseType(i);
+            out()->printf("ERASE_TYPE_%d: %lu 0x%02x\r\n", i + 1, eraseType.size, eraseType.opcode);
+        }
+        out()->printf("TOTAL_SECTORS: %lu\r\n", sst26.getTotalSectors());
+
+        return runReturn::FINISHED;
+    }
+
+
+    runReturn runBench() {
+        using ReadMode = Stm32LevelX::Driver::Sst26Driver::ReadMode;
+        A = std::max(A, static_cast<int32_t>(0));
+        S = S <= 0 || S > static_cast<int32_t>(sizeof(sector)) ? static_cast<int32_t>(sizeof(sector)) : S;
+        out()->printf("START_ADDRESS: 0x%08x\r\n", A);
+        out()->printf("SIZE: %d\r\n", S);
+        out()->printf("SPI_CLOCK: %lu\r\n", sst26Transport.getClockHz());
+        out()->printf("LANES: %d\r\n", sst26Transport.getMaxLanes());
+        out()->printf("AUTO: %s\r\n", Stm32LevelX::Driver::Sst26Driver::getReadModeName(sst26.getEffectiveReadMode()));
+
+        constexpr uint16_t ROUNDS = 256;
+        const auto previousMode = sst26.getReadMode();
+        auto result = runReturn::FINISHED;
+
+        for (const auto mode: {
+                 ReadMode::READ, ReadMode::READ_HS, ReadMode::SDOR, ReadMode::SDIOR, ReadMode::SQOR, ReadMode::SQIOR
+             }) {
+            out()->printf("%s: ", Stm32LevelX::Driver::Sst26Driver::getReadModeName(mode));
+            const uint8_t lanes = mode == ReadMode::SQOR || mode == ReadMode::SQIOR
+                                      ? 4
+                                      : mode == ReadMode::SDOR || mode == ReadMode::SDIOR
+                                            ? 2
+                                            : 1;
+            if (sst26Transport.getMaxLanes() < lanes) {
+                out()->printf("n/a\r\n");
+                continue;
+            }
+            sst26.setReadMode(mode);
+            const uint32_t start = millis();
+            for (uint16_t round = 0; round < ROUNDS && result == runReturn::FINISHED; round++) {
+                if (sst26.read(A + round * S, reinterpret_cast<uint8_t *>(sector), S) != LX_SUCCESS) {
+                    result = runReturn::ERROR;
+                }
+            }
+            const uint32_t elapsed = std::max(millis() - start, static_cast<uint32_t>(1));
+            if (result != runReturn::FINISHED) break;
+            out()->printf("%lu bytes/s\r\n", static_cast<uint32_t>(
+                              static_cast<uint64_t>(ROUNDS) * S * 1000 / elapsed));
+        }
+
+        sst26.setReadMode(previousMode);
+        return result;
+    }
+
+
     runReturn run() override {
         auto result = AbstractCommand::run();
 
@@ -155,6 +227,12 @@ public:
         if (strcmp(C, "chiperase") == 0) {
             result = runChipErase();
         }
+        if (strcmp(C, "info") == 0) {
+            result = runInfo();
+        }
+        if (strcmp(C, "bench") == 0) {
+            result = runBench();
+        }
 
 
         out()->println();
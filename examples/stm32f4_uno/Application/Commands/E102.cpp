@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+/**
+ * LevelX statistics.
+ * E102
+ */
+
+#include "E102.hpp"
+
+E102 E102;
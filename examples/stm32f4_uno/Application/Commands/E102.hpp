@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+/**
+ * LevelX statistics.
+ * E102
+ */
+
+#ifndef STM32F4_UNO_APPLICATION_COMMANDS_E102_HPP
+#define STM32F4_UNO_APPLICATION_COMMANDS_E102_HPP
+
+#include "AbstractCommand.hpp"
+#include "defines.h"
+#include "globals.hpp"
+#include "Helper.hpp"
+
+using namespace Stm32ItmLogger;
+
+class E102 : public Stm32GcodeRunner::AbstractCommand {
+public:
+    E102() { isSync = true; }
+
+    const char *getName() override {
+        return F("E102");
+    }
+
+    preFlightCheckReturn preFlightCheck() override {
+        auto result = AbstractCommand::preFlightCheck();
+        result = preFlightCheckReturn::READY;
+        return result;
+    }
+
+    initReturn init() override {
+        auto result = AbstractCommand::init();
+        result = initReturn::READY;
+        return result;
+    }
+
+
+    /**
+     * Prints numerator / denominator with two decimals, without using the float support of printf.
+     */
+    void printRatio(const char *name, const uint64_t numerator, const uint64_t denominator) {
+        out()->printf("%s: ", name);
+        if (denominator == 0) {
+            out()->printf("n/a\r\n");
+            return;
+        }
+        const auto hundredths = static_cast<uint32_t>((numerator * 100 + denominator / 2) / denominator);
+        out()->printf("%lu.%02lu\r\n", hundredths / 100, hundredths % 100);
+    }
+
+
+    runReturn runStatistics() {
+        if (!LX.isOpen()) {
+            out()->printf("NOT OPEN\r\n");
+            return runReturn::ERROR;
+        }
+
+        const auto s = LX.getStatistics();
+        const uint32_t totalSectors = s.totalBlocks * s.sectorsPerBlock;
+
+        out()->printf("TOTAL_BLOCKS: %lu\r\n", s.totalBlocks);
+        out()->printf("SECTORS_PER_BLOCK: %lu\r\n", s.sectorsPerBlock);
+        out()->printf("FREE_SECTORS: %lu\r\n", s.freeSectors);
+        out()->printf("MAPPED_SECTORS: %lu\r\n", s.mappedSectors);
+        out()->printf("OBSOLETE_SECTORS: %lu\r\n", s.obsoleteSectors);
+        out()->printf("ERASE_COUNT: %lu..%lu\r\n", s.minEraseCount, s.maxEraseCount);
+        out()->printf("READ_REQUESTS: %lu\r\n", s.readRequests);
+        out()->printf("WRITE_REQUESTS: %lu\r\n", s.writeRequests);
+        out()->printf("SECTOR_ALLOCATIONS: %lu\r\n", s.sectorAllocations);
+        out()->printf("SECTOR_ALLOCATION_ERRORS: %lu\r\n", s.sectorAllocationErrors);
+        out()->printf("MAPPING_CACHE: %lu hits, %lu misses\r\n", s.mappingCacheHits, s.mappingCacheMisses);
+        out()->printf("EXTENDED_CACHE: %lu hits, %lu misses\r\n", s.extendedCacheHits, s.extendedCacheMisses);
+        out()->printf("BLOCK_ERASES: %lu\r\n", s.blockErases);
+        out()->printf("WORDS_WRITTEN: %lu\r\n", s.wordsWritten);
+        out()->printf("SYSTEM_ERRORS: %lu (last 0x%02lx)\r\n", s.systemErrors, s.lastSystemError);
+        out()->printf("OPEN: format=%lu erased=%lu re_erased=%lu obsoleted=%lu invalidated=%lu interrupted=%lu "
+                      "not_free=%lu data_not_free=%lu\r\n",
+                      s.initialFormat, s.openErasedBlocks, s.openReErasedBlocks, s.openSectorsObsoleted,
+                      s.openMappingsInvalidated, s.openMappingWritesInterrupted, s.openSectorsNotFree,
+                      s.openSectorDataNotFree);
+
+        // Bytes programmed, including mapping entries and the moves of the reclaim, per byte written by the user
+        printRatio("WRITE_AMPLIFICATION", static_cast<uint64_t>(s.wordsWritten) * sizeof(ULONG),
+                   static_cast<uint64_t>(s.writeRequests) * Stm32LevelX::LevelXNorFlash::getSectorSize());
+        printRatio("SECTORS_PER_WRITE", s.sectorAllocations, s.writeRequests);
+        printRatio("ERASES_PER_1000_WRITES", static_cast<uint64_t>(s.blockErases) * 1000, s.writeRequests);
+        printRatio("MAPPING_CACHE_HIT_PERCENT", static_cast<uint64_t>(s.mappingCacheHits) * 100,
+                   static_cast<uint64_t>(s.mappingCacheHits) + s.mappingCacheMisses);
+        printRatio("EXTENDED_CACHE_HIT_PERCENT", static_cast<uint64_t>(s.extendedCacheHits) * 100,
+                   static_cast<uint64_t>(s.extendedCacheHits) + s.extendedCacheMisses);
+        printRatio("FREE_PERCENT", static_cast<uint64_t>(s.freeSectors) * 100, totalSectors);
+        out()->printf("ERASE_COUNT_SPREAD: %lu\r\n", s.maxEraseCount - s.minEraseCount);
+
+        if (strcmp(C, "reset") == 0) {
+            LX.resetStatistics();
+            out()->printf("RESET\r\n");
+        }
+
+        return runReturn::FINISHED;
+    }
+
+
+    runReturn run() override {
+        auto result = AbstractCommand::run();
+
+        out()->println(F("LEVELX STATISTICS"));
+
+        result = runStatistics();
+
+        out()->println();
+
+        return result;
+    }
+
+    cleanupReturn cleanup() override {
+        auto result = AbstractCommand::cleanup();
+
+        memset(C, 0, sizeof(C));
+
+        result = cleanupReturn::OK;
+        return result;
+    }
+
+    int findFirstOf(const char *str, const char *chars) {
+        for (int i = 0; str[i] != '\0'; i++) {
+            for (int j = 0; chars[j] != '\0'; j++) {
+                if (str[i] == chars[j]) {
+                    return i;
+                }
+            }
+        }
+        return -1;
+    }
+
+    void setParam(char paramName, const char *paramString) override {
+        const auto pos = findFirstOf(paramString, " \n\r\t\v\x00");
+
+        switch (paramName) {
+            case 'C':
+                snprintf(C, sizeof(C), "%.*s", pos, paramString);
+                break;
+
+            default:
+                break;
+        }
+        AbstractCommand::setParam(paramName, paramString);
+    }
+
+private:
+    char C[16] = {};
+};
+
+#endif
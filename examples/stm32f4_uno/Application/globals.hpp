@@ -16,6 +16,7 @@
 #include <cstdint>
 #include <LevelXNorFlash.hpp>
 #include <Driver/Sst26Driver.hpp>
+#include <Driver/Transport/Stm32SpiTransport.hpp>
 
 #include "SerialGcode.hpp"
 #include "Stm32Serial.hpp"
@@ -40,7 +41,9 @@ inline Stm32Gpio::PinDigitalOut pinSpi1Nss(SPI1_NSS_GPIO_Port, SPI1_NSS_Pin, tru
 
 inline Stm32Spi::Spi spi(&hspi1, &pinSpi1Nss/*, &Stm32ItmLogger::logger*/);
 
-inline Stm32LevelX::Driver::Sst26Driver sst26(&spi/*, &Stm32ItmLogger::logger*/);
+inline Stm32LevelX::Driver::Stm32SpiTransport sst26Transport(&spi, &hspi1);
+
+inline Stm32LevelX::Driver::Sst26Driver sst26(&sst26Transport/*, &Stm32ItmLogger::logger*/);
 
 inline Stm32LevelX::LevelXNorFlash LX(&sst26, &Stm32ItmLogger::logger);
 
@@ -58,6 +58,17 @@
 */
 /* #define LX_NOR_SECTOR_MAPPING_CACHE_SIZE         16 */
 
+/* Defined, this lets a NOR instance keep the mapping of every logical sector in RAM
+   supplied by the driver initialization, such that there are no cache misses.
+*/
+/* #define LX_NOR_FLASH_DIRECT_MAPPING_CACHE */
+
+/* Defined, this lets a NOR instance keep the free sector bit maps of all blocks in RAM
+   supplied by the driver initialization, such that allocations skip full blocks without
+   reading the flash.
+*/
+/* #define LX_NOR_FLASH_FREE_BIT_MAP_CACHE */
+
 /* Defined, this makes LevelX thread-safe by using a ThreadX mutex object
    throughout the API.
 */
@@ -234,6 +234,30 @@ typedef unsigned long long                      ULONG64;
 #define LX_NOR_SECTOR_MAPPING_CACHE_ENTRY_MASK      0x7FFFFFFF
 #define LX_NOR_SECTOR_MAPPING_CACHE_ENTRY_VALID     0x80000000
 
+
+/* Define the values of the NOR direct mapping cache entries. A known mapped entry holds the word offset
+   of the physical sector mapping entry from the flash base address, plus one.  */
+
+#define LX_NOR_DIRECT_MAPPING_UNKNOWN               0
+#define LX_NOR_DIRECT_MAPPING_NOT_MAPPED            LX_ALL_ONES
+
+
+/* Define the number of words the NOR free bit map cache needs: the free sector bit maps of all blocks, 
+   followed by the map of blocks that may have free sectors and the map of blocks in the cache.  */
+
+#define LX_NOR_FLASH_FREE_BIT_MAP_CACHE_WORDS(total_blocks, bit_map_words) \
+                                                    (((total_blocks) * (bit_map_words)) + (2 * (((total_blocks) + 31) / 32)))
+
+
+/* Define the bit scan that returns the index of the lowest set bit of a non-zero word. Without it, the
+   bits are tested one by one.  */
+
+#ifndef LX_NOR_FLASH_LOWEST_BIT_SET
+#if defined(__GNUC__) || defined(__clang__)
+#define LX_NOR_FLASH_LOWEST_BIT_SET(word)           ((ULONG) __builtin_ctz((unsigned int) (word)))
+#endif
+#endif
+
 #define LX_NOR_PHYSICAL_SECTOR_VALID                0x80000000
 #define LX_NOR_PHYSICAL_SECTOR_SUPERCEDED           0x40000000
 #define LX_NOR_PHYSICAL_SECTOR_MAPPING_NOT_VALID    0x20000000
@@ -479,6 +503,7 @@ typedef struct LX_NOR_FLASH_STRUCT
     ULONG                           lx_nor_flash_diagnostic_mapping_write_interrupted;
     ULONG                           lx_nor_flash_diagnostic_sector_not_free;
     ULONG                           lx_nor_flash_diagnostic_sector_data_not_free;
+    UINT                            lx_nor_flash_mount_state_restored;
 
     UINT                            (*lx_nor_flash_driver_read)(ULONG *flash_address, ULONG *destination, ULONG words);
     UINT                            (*lx_nor_flash_driver_write)(ULONG *flash_address, ULONG *source, ULONG words);
@@ -491,6 +516,26 @@ typedef struct LX_NOR_FLASH_STRUCT
     LX_NOR_SECTOR_MAPPING_CACHE_ENTRY   
                                     lx_nor_flash_sector_mapping_cache[LX_NOR_SECTOR_MAPPING_CACHE_SIZE];
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+    /* Logical sector to physical sector map in RAM, supplied by the driver initialization. Logical
+       sectors beyond the number of entries use the sector mapping cache.  */
+    ULONG                           *lx_nor_flash_direct_mapping;
+    ULONG                           lx_nor_flash_direct_mapping_entries;
+#endif
+
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+    /* Copy of the free sector bit maps in RAM, supplied by the driver initialization. A set bit in the
+       free block map means the block may have free sectors, a set bit in the valid map means the cache
+       holds the free sector bit map of the block.  */
+    ULONG                           *lx_nor_flash_free_bit_map_cache;
+    ULONG                           lx_nor_flash_free_bit_map_cache_words;
+    ULONG                           *lx_nor_flash_free_bit_map_cache_valid;
+    ULONG                           *lx_nor_flash_free_block_map;
+    ULONG                           lx_nor_flash_free_block_map_words;
+#endif
+
 #ifndef LX_NOR_DISABLE_EXTENDED_CACHE
 
     UINT                            lx_nor_flash_extended_cache_entries;
@@ -192,6 +192,25 @@ UINT    status;
             /* Return the error.  */
             return(status);
         }
+
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+        /* Determine if the free bit map cache is enabled.  */
+        if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+        {
+
+            /* All physical sectors of the erased block are free.  */
+            for (i = 0; i < (nor_flash -> lx_nor_flash_block_bit_map_words - 1); i++)
+            {
+                nor_flash -> lx_nor_flash_free_bit_map_cache[(erase_block * nor_flash -> lx_nor_flash_block_bit_map_words) + i] =  LX_ALL_ONES;
+            }
+            nor_flash -> lx_nor_flash_free_bit_map_cache[(erase_block * nor_flash -> lx_nor_flash_block_bit_map_words) + i] =  nor_flash -> lx_nor_flash_block_bit_map_mask;
+
+            /* Mark the cached bit map valid and the block as having free sectors.  */
+            nor_flash -> lx_nor_flash_free_bit_map_cache_valid[erase_block / 32] |=  ((ULONG) 1) << (erase_block % 32);
+            nor_flash -> lx_nor_flash_free_block_map[erase_block / 32] |=            ((ULONG) 1) << (erase_block % 32);
+        }
+#endif
         
         /* Write the initial erase count for the block with upper bit set.  */
         temp_erase_count =  (erase_count | LX_BLOCK_ERASED);
@@ -437,6 +456,17 @@ UINT    status;
                             /* Return the error.  */
                             return(status);
                         }
+
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+                        /* Determine if the direct mapping cache covers this sector.  */
+                        if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+                        {
+
+                            /* Remember the new mapping entry of the moved sector.  */
+                            nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  (ULONG) (new_mapping_address - nor_flash -> lx_nor_flash_base_address) + 1;
+                        }
+#endif
                     }
                     else
                     {
@@ -525,6 +555,25 @@ UINT    status;
                 return(status);
             }
 
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+            /* Determine if the free bit map cache is enabled.  */
+            if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+            {
+
+                /* All physical sectors of the erased block are free.  */
+                for (i = 0; i < (nor_flash -> lx_nor_flash_block_bit_map_words - 1); i++)
+                {
+                    nor_flash -> lx_nor_flash_free_bit_map_cache[(erase_block * nor_flash -> lx_nor_flash_block_bit_map_words) + i] =  LX_ALL_ONES;
+                }
+                nor_flash -> lx_nor_flash_free_bit_map_cache[(erase_block * nor_flash -> lx_nor_flash_block_bit_map_words) + i] =  nor_flash -> lx_nor_flash_block_bit_map_mask;
+
+                /* Mark the cached bit map valid and the block as having free sectors.  */
+                nor_flash -> lx_nor_flash_free_bit_map_cache_valid[erase_block / 32] |=  ((ULONG) 1) << (erase_block % 32);
+                nor_flash -> lx_nor_flash_free_block_map[erase_block / 32] |=            ((ULONG) 1) << (erase_block % 32);
+            }
+#endif
+
             /* Write the initial erase count for the block with the upper bit set.  */
             temp_erase_count =  (erase_count | LX_BLOCK_ERASED);
             status =  _lx_nor_flash_driver_write(nor_flash, block_word_ptr, &temp_erase_count, 1);
@@ -119,6 +119,48 @@ UINT                                status;
         return(LX_SECTOR_NOT_FOUND);
     }
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+    /* Determine if the direct mapping cache covers this sector. The superceded check is only done by
+       the open logic, which needs to walk the mapping lists.  */
+    if ((superceded_check == LX_FALSE) && (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries))
+    {
+
+        /* Pickup the direct mapping cache entry.  */
+        list_word =  nor_flash -> lx_nor_flash_direct_mapping[logical_sector];
+
+        /* Determine if the mapping of this sector is known.  */
+        if (list_word != LX_NOR_DIRECT_MAPPING_UNKNOWN)
+        {
+
+            /* Increment the sector mapping cache hit counter.  */
+            nor_flash -> lx_nor_flash_sector_mapping_cache_hits++;
+
+            /* Determine if the sector is mapped at all.  */
+            if (list_word == LX_NOR_DIRECT_MAPPING_NOT_MAPPED)
+            {
+
+                /* No, the sector is not mapped.  */
+                return(LX_SECTOR_NOT_FOUND);
+            }
+
+            /* Calculate the block and the index of the entry in the mapping list of the block.  */
+            i =  (list_word - 1) / nor_flash -> lx_nor_flash_words_per_block;
+            j =  (list_word - 1) - (i * nor_flash -> lx_nor_flash_words_per_block) - nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset;
+
+            /* Setup the block word pointer to the first word of the block.  */
+            block_word_ptr =  nor_flash -> lx_nor_flash_base_address + (i * nor_flash -> lx_nor_flash_words_per_block);
+
+            /* Return the mapping entry and the physical sector.  */
+            *physical_sector_map_entry =  block_word_ptr + nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset + j;
+            *physical_sector_address =    block_word_ptr + nor_flash -> lx_nor_flash_block_physical_sector_offset + (j * LX_NOR_SECTOR_SIZE);
+
+            /* Return a successful status.  */
+            return(LX_SUCCESS);
+        }
+    }
+#endif
+
     /* Determine if the sector mapping cache is enabled.  */
     if (nor_flash -> lx_nor_flash_sector_mapping_cache_enabled)
     {
@@ -394,6 +436,17 @@ UINT                                status;
                             sector_mapping_cache_entry_ptr -> lx_nor_sector_mapping_cache_physical_sector_address =    *physical_sector_address;
                         }
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+                        /* Determine if the direct mapping cache covers this sector.  */
+                        if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+                        {
+
+                            /* Remember the mapping entry of this sector.  */
+                            nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  (ULONG) (list_word_ptr - nor_flash -> lx_nor_flash_base_address) + 1;
+                        }
+#endif
+
                         /* Remember the last found block for next search.  */
                         nor_flash -> lx_nor_flash_found_block_search =  i;
                         
@@ -473,6 +526,17 @@ UINT                                status;
         j =  0;
     }
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+    /* Determine if the direct mapping cache covers this sector.  */
+    if ((superceded_check == LX_FALSE) && (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries))
+    {
+
+        /* Remember that the sector is not mapped.  */
+        nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  LX_NOR_DIRECT_MAPPING_NOT_MAPPED;
+    }
+#endif
+
     /* Return sector not found status.  */
     return(LX_SECTOR_NOT_FOUND);  
 }
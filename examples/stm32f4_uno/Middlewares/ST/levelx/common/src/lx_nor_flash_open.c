@@ -207,6 +207,46 @@ LX_INTERRUPT_SAVE_AREA
 
     /* Save the free bit map mask in the control block.  */
     nor_flash -> lx_nor_flash_block_bit_map_mask =  bit_map_mask;
+
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+    /* Determine if the driver supplied enough memory for the free bit map cache.  */
+    if (nor_flash -> lx_nor_flash_free_bit_map_cache_words < LX_NOR_FLASH_FREE_BIT_MAP_CACHE_WORDS(nor_flash -> lx_nor_flash_total_blocks, bit_map_words))
+    {
+
+        /* No, disable the cache.  */
+        nor_flash -> lx_nor_flash_free_bit_map_cache =  LX_NULL;
+    }
+
+    /* Determine if the free bit map cache is enabled.  */
+    if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+    {
+
+        /* Setup the free block map and the valid map behind the free sector bit maps.  */
+        nor_flash -> lx_nor_flash_free_block_map_words =      (nor_flash -> lx_nor_flash_total_blocks + 31) / 32;
+        nor_flash -> lx_nor_flash_free_block_map =            nor_flash -> lx_nor_flash_free_bit_map_cache + (nor_flash -> lx_nor_flash_total_blocks * bit_map_words);
+        nor_flash -> lx_nor_flash_free_bit_map_cache_valid =  nor_flash -> lx_nor_flash_free_block_map + nor_flash -> lx_nor_flash_free_block_map_words;
+
+        /* No block is in the cache yet, so every block may have free sectors.  */
+        for (j = 0; j < nor_flash -> lx_nor_flash_free_block_map_words; j++)
+        {
+            nor_flash -> lx_nor_flash_free_block_map[j] =            LX_ALL_ONES;
+            nor_flash -> lx_nor_flash_free_bit_map_cache_valid[j] =  0;
+        }
+
+        /* Clear the bits beyond the last block.  */
+        if ((nor_flash -> lx_nor_flash_total_blocks % 32) != 0)
+        {
+            nor_flash -> lx_nor_flash_free_block_map[j - 1] =  (((ULONG) 1) << (nor_flash -> lx_nor_flash_total_blocks % 32)) - 1;
+        }
+    }
+#endif
+    
+    /* Determine if the driver initialization restored the state of the last clean close. In that case the
+       driver has set up the sector counts, the erase counts and the free block search, and the blocks
+       are not scanned.  */
+    if (nor_flash -> lx_nor_flash_mount_state_restored == LX_FALSE)
+    {
     
     /* Setup default values for the max/min erased counts.  */
     min_erased_count =  LX_ALL_ONES;
@@ -505,6 +545,17 @@ LX_INTERRUPT_SAVE_AREA
                     }
 #endif
                     
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+                    /* Determine if the free bit map cache is enabled.  */
+                    if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+                    {
+
+                        /* Save the word of the free sector bit map in the cache.  */
+                        nor_flash -> lx_nor_flash_free_bit_map_cache[(l * bit_map_words) + j] =  block_word;
+                    }
+#endif
+
                     /* Count the number of set bits (free sectors).  */
                     for (k = 0; k < 32; k++)
                     {
@@ -532,6 +583,25 @@ LX_INTERRUPT_SAVE_AREA
                 /* Update the number of free physical sectors.  */
                 nor_flash -> lx_nor_flash_free_physical_sectors =   nor_flash -> lx_nor_flash_free_physical_sectors + free_sectors;
 
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+                /* Determine if the free bit map cache is enabled.  */
+                if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+                {
+
+                    /* The cache now holds the free sector bit map of this block.  */
+                    nor_flash -> lx_nor_flash_free_bit_map_cache_valid[l / 32] |=  ((ULONG) 1) << (l % 32);
+
+                    /* Determine if the block has no free sectors.  */
+                    if (free_sectors == 0)
+                    {
+
+                        /* Skip this block when searching for a free sector.  */
+                        nor_flash -> lx_nor_flash_free_block_map[l / 32] &=  ~(((ULONG) 1) << (l % 32));
+                    }
+                }
+#endif
+
                 /* We need to now examine the mapping list.  */
                     
                 /* Calculate how many non-free sectors there are - this includes valid and obsolete sectors.  */
@@ -707,6 +777,18 @@ LX_INTERRUPT_SAVE_AREA
                         {
                             /* Increment the number of mapped physical sectors.  */
                             nor_flash -> lx_nor_flash_mapped_physical_sectors++;
+
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+                            /* Determine if the direct mapping cache covers this sector.  */
+                            if ((block_word & LX_NOR_LOGICAL_SECTOR_MASK) < nor_flash -> lx_nor_flash_direct_mapping_entries)
+                            {
+
+                                /* Remember the mapping entry of this sector.  */
+                                nor_flash -> lx_nor_flash_direct_mapping[block_word & LX_NOR_LOGICAL_SECTOR_MASK] =
+                                    (ULONG) ((block_word_ptr + nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset + j) - nor_flash -> lx_nor_flash_base_address) + 1;
+                            }
+#endif
                         }
                         
                         /* Decrease the number of used sectors.  */
@@ -810,6 +892,23 @@ LX_INTERRUPT_SAVE_AREA
         }
     }
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+    /* All blocks have been scanned, so the sectors without a mapping entry are not mapped.  */
+    for (j = 0; j < nor_flash -> lx_nor_flash_direct_mapping_entries; j++)
+    {
+
+        /* Determine if the scan found no mapping for this sector.  */
+        if (nor_flash -> lx_nor_flash_direct_mapping[j] == LX_NOR_DIRECT_MAPPING_UNKNOWN)
+        {
+
+            /* Remember that the sector is not mapped.  */
+            nor_flash -> lx_nor_flash_direct_mapping[j] =  LX_NOR_DIRECT_MAPPING_NOT_MAPPED;
+        }
+    }
+#endif
+    }
+
 #ifdef LX_THREAD_SAFE_ENABLE
 
     /* If the thread safe option is enabled, create a ThreadX mutex that will be used in all external APIs 
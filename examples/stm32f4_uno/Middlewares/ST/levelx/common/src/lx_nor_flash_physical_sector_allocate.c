@@ -94,6 +94,10 @@ ULONG   *list_word_ptr;
 ULONG   list_word;
 ULONG   i, j, k, l;
 UINT    status;
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+ULONG   *bit_map_cache_ptr =  LX_NULL;
+ULONG   block_bit =  0;
+#endif
 
 
     /* Increment the number of physical sector allocation requests.  */
@@ -121,20 +125,97 @@ UINT    status;
     for (i = 0; i < nor_flash -> lx_nor_flash_total_blocks; i++)
     {
 
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+        /* Determine if the free bit map cache is enabled.  */
+        if (nor_flash -> lx_nor_flash_free_bit_map_cache)
+        {
+
+            /* Pickup the word of the free block map with the search block, without the blocks before it.  */
+            j =  search_block / 32;
+            block_word =  nor_flash -> lx_nor_flash_free_block_map[j] & (LX_ALL_ONES << (search_block % 32));
+
+            /* Skip the words without blocks that may have free sectors, at most once around the map.  */
+            l =  0;
+            while ((block_word == 0) && (l < nor_flash -> lx_nor_flash_free_block_map_words))
+            {
+
+                /* Move to the next word of the free block map.  */
+                j++;
+
+                /* Determine if we have to wrap the word.  */
+                if (j >= nor_flash -> lx_nor_flash_free_block_map_words)
+                {
+
+                    /* Set the word to the beginning.  */
+                    j =  0;
+                }
+
+                /* Pickup the next word of the free block map.  */
+                block_word =  nor_flash -> lx_nor_flash_free_block_map[j];
+                l++;
+            }
+
+            /* Determine if there is no block with free sectors.  */
+            if (block_word == 0)
+            {
+
+                /* Stop the search.  */
+                break;
+            }
+
+            /* Calculate the next block that may have free sectors.  */
+#ifdef LX_NOR_FLASH_LOWEST_BIT_SET
+            k =  (j * 32) + LX_NOR_FLASH_LOWEST_BIT_SET(block_word);
+#else
+            k =  j * 32;
+            while ((block_word & 1) == 0)
+            {
+                block_word =  block_word >> 1;
+                k++;
+            }
+#endif
+
+            /* Account for the skipped blocks.  */
+            if (k >= search_block)
+                i =  i + (k - search_block);
+            else
+                i =  i + (k + nor_flash -> lx_nor_flash_total_blocks - search_block);
+
+            /* Determine if the search went around all blocks.  */
+            if (i >= nor_flash -> lx_nor_flash_total_blocks)
+            {
+
+                /* Stop the search.  */
+                break;
+            }
+
+            /* Continue the search at this block.  */
+            search_block =  k;
+            block_bit =  ((ULONG) 1) << (search_block % 32);
+            bit_map_cache_ptr =  nor_flash -> lx_nor_flash_free_bit_map_cache + (search_block * nor_flash -> lx_nor_flash_block_bit_map_words);
+        }
+#endif
+
         /* Setup the block word pointer to the first word of the search block.  */
         block_word_ptr =  nor_flash -> lx_nor_flash_base_address + (search_block * nor_flash -> lx_nor_flash_words_per_block);
 
-        /* Find the first free physical sector from the free sector bit map of this block.  */
-        for (j = 0; j < nor_flash -> lx_nor_flash_block_bit_map_words; j++)
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+        /* Determine if the free bit map of this block is not in the cache yet.  */
+        if ((bit_map_cache_ptr) && ((nor_flash -> lx_nor_flash_free_bit_map_cache_valid[search_block / 32] & block_bit) == 0))
         {
-                
-            /* Read this word of the free sector bit map.  */
+
+            /* Read the free sector bit map of this block into the cache.  */
 #ifdef LX_DIRECT_READ
-        
-            /* Read the word directly.  */
-            block_word =  *(block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j);
+
+            /* Read the words directly.  */
+            for (j = 0; j < nor_flash -> lx_nor_flash_block_bit_map_words; j++)
+            {
+                *(bit_map_cache_ptr + j) =  *(block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j);
+            }
 #else
-            status =  _lx_nor_flash_driver_read(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j), &block_word, 1);
+            status =  _lx_nor_flash_driver_read(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset), bit_map_cache_ptr, nor_flash -> lx_nor_flash_block_bit_map_words);
 
             /* Check for an error from flash driver. Drivers should never return an error..  */
             if (status)
@@ -142,38 +223,152 @@ UINT    status;
         
                 /* Call system error handler.  */
                 _lx_nor_flash_system_error(nor_flash, status);
-                
+
                 /* Return the error.  */
                 return(status);
             }
 #endif
-                    
+
+            /* The cache now holds the free bit map of this block.  */
+            nor_flash -> lx_nor_flash_free_bit_map_cache_valid[search_block / 32] |=  block_bit;
+
+            /* Determine if the block has any free sectors.  */
+            for (j = 0; j < nor_flash -> lx_nor_flash_block_bit_map_words; j++)
+            {
+                if (*(bit_map_cache_ptr + j))
+                    break;
+            }
+            if (j == nor_flash -> lx_nor_flash_block_bit_map_words)
+            {
+
+                /* No, skip this block in the following searches.  */
+                nor_flash -> lx_nor_flash_free_block_map[search_block / 32] &=  ~block_bit;
+            }
+        }
+#endif
+
+        /* Find the first free physical sector from the free sector bit map of this block.  */
+        for (j = 0; j < nor_flash -> lx_nor_flash_block_bit_map_words; j++)
+        {
+
+            /* Read this word of the free sector bit map.  */
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+            if (bit_map_cache_ptr)
+            {
+
+                /* Pickup the word from the free bit map cache.  */
+                block_word =  *(bit_map_cache_ptr + j);
+            }
+            else
+#endif
+            {
+#ifdef LX_DIRECT_READ
+            
+                /* Read the word directly.  */
+                block_word =  *(block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j);
+#else
+                status =  _lx_nor_flash_driver_read(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j), &block_word, 1);
+
+                /* Check for an error from flash driver. Drivers should never return an error..  */
+                if (status)
+                {
+        
+                    /* Call system error handler.  */
+                    _lx_nor_flash_system_error(nor_flash, status);
+
+                    /* Return the error.  */
+                    return(status);
+                }
+#endif
+            }
+
             /* Are there any free sectors in this word?  */
             if (block_word)
             {
-            
-                /* Yes, there are free sectors in this word.  */
-                for (k = 0; k < 32; k++)
+
+                /* Yes, there are free sectors in this word. Find the first one.  */
+#ifdef LX_NOR_FLASH_LOWEST_BIT_SET
+                k =  LX_NOR_FLASH_LOWEST_BIT_SET(block_word);
+#else
+                k =  0;
+                while ((block_word & (((ULONG) 1) << k)) == 0)
                 {
-                    
-                    /* Is this sector free?  */
-                    if (block_word & 1)
+                    k++;
+                }
+#endif
+
+                /* Clear the bit associated with the free sector to indicate it is not free.  */
+                block_word =  block_word & ~(((ULONG) 1) << k);
+
+                /* Now write back free bit map word with the bit for this sector cleared.  */
+                status =  _lx_nor_flash_driver_write(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j), &block_word, 1);
+
+                /* Check for an error from flash driver. Drivers should never return an error..  */
+                if (status)
+                {
+        
+                    /* Call system error handler.  */
+                    _lx_nor_flash_system_error(nor_flash, status);
+
+                    /* Return the error.  */
+                    return(status);
+                }
+
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+
+                /* Determine if the free bit map cache is enabled.  */
+                if (bit_map_cache_ptr)
+                {
+
+                    /* Update the cached word of the free sector bit map.  */
+                    *(bit_map_cache_ptr + j) =  block_word;
+
+                    /* Determine if the block has any free sectors left.  */
+                    for (l = 0; l < nor_flash -> lx_nor_flash_block_bit_map_words; l++)
+                    {
+                        if (*(bit_map_cache_ptr + l))
+                            break;
+                    }
+                    if (l == nor_flash -> lx_nor_flash_block_bit_map_words)
+                    {
+
+                        /* No, skip this block in the following searches.  */
+                        nor_flash -> lx_nor_flash_free_block_map[search_block / 32] &=  ~block_bit;
+                    }
+                }
+#endif
+
+
+                /* Determine if this is the last entry available in this block.  */
+                if (((block_word >> 1) == 0) && (j == (nor_flash -> lx_nor_flash_block_bit_map_words - 1)))
+                {
+
+                    /* This is the last physical sector in the block.  Now we need to calculate the minimum valid logical
+                       sector and the maximum valid logical sector.  */
+
+                    /* Setup the minimum and maximum logical sectors to the current logical sector.  */
+                    min_logical_sector =  logical_sector;
+                    max_logical_sector =  logical_sector;
+
+                    /* Setup a pointer to the mapped list.  */
+                    list_word_ptr =  block_word_ptr + nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset;
+
+                    /* Loop to search the mapped list.  */
+                    for (l = 0; l < nor_flash -> lx_nor_flash_physical_sectors_per_block; l++)
                     {
-                        
-                        /* Yes, this sector is free, clear the bit for this sector in the free sector map.  */
-                        
-                        /* Read this word of the free sector bit map again.  */
+
+                        /* Read the mapped sector entry.  */
 #ifdef LX_DIRECT_READ
-        
+
                         /* Read the word directly.  */
-                        block_word =  *(block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j);
+                        list_word =  *(list_word_ptr);
 #else
-                        status =  _lx_nor_flash_driver_read(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j), &block_word, 1);
+                        status =  _lx_nor_flash_driver_read(nor_flash, list_word_ptr, &list_word, 1);
 
                         /* Check for an error from flash driver. Drivers should never return an error..  */
                         if (status)
                         {
-        
+
                             /* Call system error handler.  */
                             _lx_nor_flash_system_error(nor_flash, status);
 
@@ -181,145 +376,81 @@ UINT    status;
                             return(status);
                         }
 #endif
-                        
-                        /* Clear the bit associated with the free sector to indicate it is not free.  */
-                        block_word =  block_word & ~(((ULONG) 1) << k);
-                        
-                        /* Now write back free bit map word with the bit for this sector cleared.  */
-                        status =  _lx_nor_flash_driver_write(nor_flash, (block_word_ptr + nor_flash -> lx_nor_flash_block_free_bit_map_offset + j), &block_word, 1);
 
-                        /* Check for an error from flash driver. Drivers should never return an error..  */
-                        if (status)
+                        /* Is this entry valid?  */
+                        if (list_word & LX_NOR_PHYSICAL_SECTOR_VALID)
                         {
-        
-                            /* Call system error handler.  */
-                            _lx_nor_flash_system_error(nor_flash, status);
-
-                            /* Return the error.  */
-                            return(status);
-                        }
 
-                        /* Determine if this is the last entry available in this block.  */
-                        if (((block_word >> 1) == 0) && (j == (nor_flash -> lx_nor_flash_block_bit_map_words - 1)))
-                        {
-                        
-                            /* This is the last physical sector in the block.  Now we need to calculate the minimum valid logical
-                               sector and the maximum valid logical sector.  */
-
-                            /* Setup the minimum and maximum logical sectors to the current logical sector.  */
-                            min_logical_sector =  logical_sector;
-                            max_logical_sector =  logical_sector;
-                               
-                            /* Setup a pointer to the mapped list.  */
-                            list_word_ptr =  block_word_ptr + nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset;
-
-                            /* Loop to search the mapped list.  */
-                            for (l = 0; l < nor_flash -> lx_nor_flash_physical_sectors_per_block; l++)
-                            {
+                            /* Isolate the logical sector.  */
+                            list_word =  list_word & LX_NOR_LOGICAL_SECTOR_MASK;
 
-                                /* Read the mapped sector entry.  */
-#ifdef LX_DIRECT_READ
-        
-                                /* Read the word directly.  */
-                                list_word =  *(list_word_ptr);
-#else
-                                status =  _lx_nor_flash_driver_read(nor_flash, list_word_ptr, &list_word, 1);
-                                
-                                /* Check for an error from flash driver. Drivers should never return an error..  */
-                                if (status)
-                                {
-        
-                                    /* Call system error handler.  */
-                                    _lx_nor_flash_system_error(nor_flash, status);
+                            /* Determine if a new minimum has been found.  */
+                            if (list_word < min_logical_sector)
+                                min_logical_sector =  list_word;
 
-                                    /* Return the error.  */
-                                    return(status);
-                                }
-#endif
-            
-                                /* Is this entry valid?  */
-                                if (list_word & LX_NOR_PHYSICAL_SECTOR_VALID)
-                                {
-
-                                    /* Isolate the logical sector.  */
-                                    list_word =  list_word & LX_NOR_LOGICAL_SECTOR_MASK;
-
-                                    /* Determine if a new minimum has been found.  */
-                                    if (list_word < min_logical_sector)
-                                        min_logical_sector =  list_word;
-                
-                                    /* Determine if a new maximum has been found.  */
-                                    if (list_word != LX_NOR_LOGICAL_SECTOR_MASK)
-                                    {
-                                        if (list_word > max_logical_sector)
-                                            max_logical_sector =  list_word;                    
-                                    }
-                                }
-
-                                /* Move the list pointer ahead.  */
-                                list_word_ptr++;
-                            }
-                            
-                            /* Move the search pointer forward, since we know this block is exhausted.  */
-                            search_block++;
-                            
-                            /* Check for wrap condition on the search block.  */
-                            if (search_block >= nor_flash -> lx_nor_flash_total_blocks)
+                            /* Determine if a new maximum has been found.  */
+                            if (list_word != LX_NOR_LOGICAL_SECTOR_MASK)
                             {
-                            
-                                /* Reset search block to the beginning.  */
-                                search_block =  0;
+                                if (list_word > max_logical_sector)
+                                    max_logical_sector =  list_word;                    
                             }
-                            
-                            /* Now write the minimum and maximum logical sector in this block.  */
-                            status =  _lx_nor_flash_driver_write(nor_flash, block_word_ptr + LX_NOR_FLASH_MIN_LOGICAL_SECTOR_OFFSET, &min_logical_sector, 1);
+                        }
 
-                            /* Check for an error from flash driver. Drivers should never return an error..  */
-                            if (status)
-                            {
-        
-                                /* Call system error handler.  */
-                                _lx_nor_flash_system_error(nor_flash, status);
+                        /* Move the list pointer ahead.  */
+                        list_word_ptr++;
+                    }
 
-                                /* Return the error.  */
-                                return(status);
-                            }
-                            
-                            status =  _lx_nor_flash_driver_write(nor_flash, block_word_ptr + LX_NOR_FLASH_MAX_LOGICAL_SECTOR_OFFSET, &max_logical_sector, 1);
+                    /* Move the search pointer forward, since we know this block is exhausted.  */
+                    search_block++;
 
-                            /* Check for an error from flash driver. Drivers should never return an error..  */
-                            if (status)
-                            {
-        
-                                /* Call system error handler.  */
-                                _lx_nor_flash_system_error(nor_flash, status);
+                    /* Check for wrap condition on the search block.  */
+                    if (search_block >= nor_flash -> lx_nor_flash_total_blocks)
+                    {
 
-                                /* Return the error.  */
-                                return(status);
-                            }
-                        }
-                                                
-                        /* Remember the block to search.  */
-                        nor_flash -> lx_nor_flash_free_block_search =  search_block;
-                                                
-                        /* Prepare the return information.  */
-                        *physical_sector_map_entry =  block_word_ptr + (nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset + (j * 32)) + k;
-                        *physical_sector_address =    block_word_ptr + (nor_flash -> lx_nor_flash_block_physical_sector_offset) + (((j * 32) + k) * LX_NOR_SECTOR_SIZE);
-
-                        /* Return success!  */
-                        return(LX_SUCCESS);                     
+                        /* Reset search block to the beginning.  */
+                        search_block =  0;
+                    }
+
+                    /* Now write the minimum and maximum logical sector in this block.  */
+                    status =  _lx_nor_flash_driver_write(nor_flash, block_word_ptr + LX_NOR_FLASH_MIN_LOGICAL_SECTOR_OFFSET, &min_logical_sector, 1);
+
+                    /* Check for an error from flash driver. Drivers should never return an error..  */
+                    if (status)
+                    {
+
+                        /* Call system error handler.  */
+                        _lx_nor_flash_system_error(nor_flash, status);
+
+                        /* Return the error.  */
+                        return(status);
+                    }
+
+                    status =  _lx_nor_flash_driver_write(nor_flash, block_word_ptr + LX_NOR_FLASH_MAX_LOGICAL_SECTOR_OFFSET, &max_logical_sector, 1);
+
+                    /* Check for an error from flash driver. Drivers should never return an error..  */
+                    if (status)
+                    {
+
+                        /* Call system error handler.  */
+                        _lx_nor_flash_system_error(nor_flash, status);
+
+                        /* Return the error.  */
+                        return(status);
                     }
-                        
-                    /* Shift down the bit map.  */
-                    block_word =  block_word >> 1;
-                    
-                    /* Determine if there are any more bits set? If not, we can break out of the search of this word.  */
-                    if (block_word == 0)
-                        break;
                 }
+
+                /* Remember the block to search.  */
+                nor_flash -> lx_nor_flash_free_block_search =  search_block;
+
+                /* Prepare the return information.  */
+                *physical_sector_map_entry =  block_word_ptr + (nor_flash -> lx_nor_flash_block_physical_sector_mapping_offset + (j * 32)) + k;
+                *physical_sector_address =    block_word_ptr + (nor_flash -> lx_nor_flash_block_physical_sector_offset) + (((j * 32) + k) * LX_NOR_SECTOR_SIZE);
+
+                /* Return success!  */
+                return(LX_SUCCESS);                     
             }
         }
-            
+
         /* Move to the next flash block.  */
         search_block++;
         
@@ -85,6 +85,17 @@ ULONG                           i;
 LX_NOR_SECTOR_MAPPING_CACHE_ENTRY  *sector_mapping_cache_entry_ptr;
 
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+    /* Determine if the direct mapping cache covers this sector.  */
+    if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+    {
+
+        /* The mapping is about to change, the caller records the new one if it knows it.  */
+        nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  LX_NOR_DIRECT_MAPPING_UNKNOWN;
+    }
+#endif
+
     /* Determine if the sector mapping cache is enabled.  */
     if (nor_flash -> lx_nor_flash_sector_mapping_cache_enabled)
     {
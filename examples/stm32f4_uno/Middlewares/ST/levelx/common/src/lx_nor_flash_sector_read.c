@@ -183,6 +183,17 @@ ULONG   *sector_address;
             /* Increment the number of mapped physical sectors.  */
             nor_flash -> lx_nor_flash_mapped_physical_sectors++;
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+            /* Determine if the direct mapping cache covers this sector.  */
+            if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+            {
+
+                /* Remember the mapping entry of this sector.  */
+                nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  (ULONG) (mapping_address - nor_flash -> lx_nor_flash_base_address) + 1;
+            }
+#endif
+
             /* Set the status to success.  */
             status =  LX_SUCCESS;
         }
@@ -173,6 +173,17 @@ ULONG   i;
         /* Ensure the sector mapping cache no longer has this sector.  */
         _lx_nor_flash_sector_mapping_cache_invalidate(nor_flash, logical_sector);
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+        /* Determine if the direct mapping cache covers this sector.  */
+        if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+        {
+
+            /* Remember that the sector is not mapped.  */
+            nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  LX_NOR_DIRECT_MAPPING_NOT_MAPPED;
+        }
+#endif
+
         /* Determine if there are less than two block's worth of free sectors.  */
         i =  0;
         while (nor_flash -> lx_nor_flash_free_physical_sectors <= nor_flash -> lx_nor_flash_physical_sectors_per_block)
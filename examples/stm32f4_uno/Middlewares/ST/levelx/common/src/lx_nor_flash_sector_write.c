@@ -333,6 +333,17 @@ UINT                            status;
             sector_mapping_cache_entry_ptr -> lx_nor_sector_mapping_cache_physical_sector_address =    new_sector_address;
         }
 
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+
+        /* Determine if the direct mapping cache covers this sector.  */
+        if (logical_sector < nor_flash -> lx_nor_flash_direct_mapping_entries)
+        {
+
+            /* Remember the new mapping entry of this sector.  */
+            nor_flash -> lx_nor_flash_direct_mapping[logical_sector] =  (ULONG) (new_mapping_address - nor_flash -> lx_nor_flash_base_address) + 1;
+        }
+#endif
+
         /* Indicate the write was successful.  */
         status =  LX_SUCCESS;        
     }
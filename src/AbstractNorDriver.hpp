@@ -6,6 +6,7 @@
 #ifndef LIBSMART_STM32LEVELX_ABSTRACTNORDRIVER_HPP
 #define LIBSMART_STM32LEVELX_ABSTRACTNORDRIVER_HPP
 
+#include <cstddef>
 #include <libsmart_config.hpp>
 #include <main.h>
 #include "lx_api.h"
@@ -14,18 +15,132 @@
 namespace Stm32LevelX {
     class AbstractNorDriver {
     public:
+        /**
+         * @brief Called when an asynchronous read has finished.
+         *
+         * @param status LX_SUCCESS or LX_ERROR.
+         * @param context Pointer that was passed to readAsync().
+         */
+        using ReadCallback = void (*)(UINT status, void *context);
+
+        /**
+         * @brief One range of a readv() or writev().
+         */
+        struct Segment {
+            uint32_t addr;
+            uint8_t *data;
+            size_t size;
+        };
+
         virtual ~AbstractNorDriver() = default;
 
         virtual ULONG getTotalSectors() = 0;
 
         virtual ULONG getSectorSize() = 0;
 
-        virtual UINT read(uint32_t addr, uint8_t *out, uint16_t size) = 0;
+        /**
+         * @brief Returns the address the flash is mapped to, if the CPU can read it directly.
+         *
+         * LevelX reads memory mapped flash directly if LX_DIRECT_READ is defined. The addresses passed to the
+         * driver are offsets from the start of the flash in either case.
+         *
+         * @return nullptr if the flash is not memory mapped.
+         */
+        virtual ULONG *getBaseAddress() { return nullptr; }
+
+        virtual UINT read(uint32_t addr, uint8_t *out, size_t size) = 0;
+
+        /**
+         * @brief Reads several ranges.
+         *
+         * Drivers override this to read ranges that are close to each other in one transaction. The default
+         * implementation calls read() for every segment.
+         *
+         * @return LX_SUCCESS, or the error of the first segment that failed.
+         */
+        virtual UINT readv(const Segment *segments, const size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                const UINT ret = read(segments[i].addr, segments[i].data, segments[i].size);
+                if (ret != LX_SUCCESS) return ret;
+            }
+            return LX_SUCCESS;
+        }
+
+        /**
+         * @brief Starts a read and returns without waiting for the data.
+         *
+         * The default implementation reads synchronously and calls the callback before it returns.
+         *
+         * @return LX_SUCCESS if the read has been started. The callback is only called in this case.
+         */
+        virtual UINT readAsync(const uint32_t addr, uint8_t *out, const size_t size,
+                               const ReadCallback callback, void *context) {
+            callback(read(addr, out, size), context);
+            return LX_SUCCESS;
+        }
 
-        virtual UINT write(uint32_t addr, uint8_t *in, uint16_t size) = 0;
+        virtual UINT write(uint32_t addr, uint8_t *in, size_t size) = 0;
+
+        /**
+         * @brief Writes several ranges, one after the other.
+         *
+         * @return LX_SUCCESS, or the error of the first segment that failed.
+         */
+        virtual UINT writev(const Segment *segments, const size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                const UINT ret = write(segments[i].addr, segments[i].data, segments[i].size);
+                if (ret != LX_SUCCESS) return ret;
+            }
+            return LX_SUCCESS;
+        }
 
         virtual UINT eraseSector(uint32_t addr, ULONG erase_count) = 0;
 
+        /**
+         * @brief Erases all sectors in [addr, addr + size).
+         *
+         * The default implementation erases one sector after the other. Drivers for devices with larger erase
+         * units override this to use as few erase commands as possible.
+         *
+         * @param addr Start address, aligned to getSectorSize().
+         * @param size Number of bytes, a multiple of getSectorSize().
+         * @return LX_SUCCESS, or LX_ERROR if the range is not aligned or an erase failed.
+         */
+        virtual UINT eraseRange(const uint32_t addr, const uint32_t size) {
+            const ULONG sectorSize = getSectorSize();
+            if (addr % sectorSize > 0 || size % sectorSize > 0) return LX_ERROR;
+            for (uint32_t offset = 0; offset < size; offset += sectorSize) {
+                const UINT ret = eraseSector(addr + offset, 0);
+                if (ret != LX_SUCCESS) return ret;
+            }
+            return LX_SUCCESS;
+        }
+
+        /**
+         * @brief Starts a write and returns while the device may still be programming.
+         *
+         * finish() waits for the device and returns the result of the write. It must be called before any other
+         * method of the driver, and in must stay valid until then. Drivers that spread the data over several
+         * devices use this to program them at the same time. The default implementation writes synchronously.
+         */
+        virtual UINT startWrite(const uint32_t addr, uint8_t *in, const size_t size) {
+            return write(addr, in, size);
+        }
+
+        /**
+         * @brief Starts a sector erase and returns while the device may still be erasing, see startWrite().
+         */
+        virtual UINT startEraseSector(const uint32_t addr, const ULONG erase_count) {
+            return eraseSector(addr, erase_count);
+        }
+
+        /**
+         * @brief Waits for the operation started by startWrite() or startEraseSector().
+         *
+         * @return The result of the operation, LX_SUCCESS if none is pending.
+         */
+        virtual UINT finish() { return LX_SUCCESS; }
+
         virtual UINT verifySectorErased(uint32_t addr) = 0;
 
         virtual UINT initialize() =0;
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Crc32.hpp"
+#include "lx_api.h"
+
+using namespace Stm32LevelX;
+
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+namespace {
+#ifndef LX_STANDALONE_ENABLE
+    TX_MUTEX unitMutex = {};
+    volatile bool unitMutexCreated = false;
+#endif
+    volatile bool unitInUse = false;
+}
+#endif
+
+Crc32::~Crc32() {
+    if (engine == Engine::HARDWARE) releaseUnit();
+}
+
+void Crc32::reset() {
+    if (engine == Engine::HARDWARE) releaseUnit();
+    engine = Engine::NONE;
+    crc = 0xFFFFFFFF;
+    partial = 0;
+    partialBytes = 0;
+}
+
+void Crc32::update(const uint8_t *data, const uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        partial |= static_cast<uint32_t>(data[i]) << (8 * partialBytes);
+        if (++partialBytes == sizeof(uint32_t)) {
+            updateWord(partial);
+            partial = 0;
+            partialBytes = 0;
+        }
+    }
+}
+
+uint32_t Crc32::get() {
+    if (partialBytes > 0) {
+        updateWord(partial | 0xFFFFFFFF << (8 * partialBytes));
+        partial = 0;
+        partialBytes = 0;
+    }
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+    if (engine == Engine::HARDWARE) {
+        // The unit has no final XOR, so its data register is the whole state. Further updates continue in software.
+        crc = CRC->DR;
+        releaseUnit();
+        engine = Engine::SOFTWARE;
+    }
+#endif
+    return crc;
+}
+
+void Crc32::updateWord(const uint32_t word) {
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+    if (engine == Engine::NONE) engine = claimUnit() ? Engine::HARDWARE : Engine::SOFTWARE;
+    if (engine == Engine::HARDWARE) {
+        CRC->DR = word;
+        return;
+    }
+#endif
+    engine = Engine::SOFTWARE;
+    crc ^= word;
+    for (uint8_t bit = 0; bit < 32; bit++) {
+        crc = crc & 0x80000000 ? crc << 1 ^ 0x04C11DB7 : crc << 1;
+    }
+}
+
+bool Crc32::claimUnit() {
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+#ifndef LX_STANDALONE_ENABLE
+    TX_THREAD *thread = tx_thread_identify();
+    if (thread != TX_NULL) {
+        if (!unitMutexCreated) {
+            // Two threads must not both create the mutex
+            const UINT interrupts = tx_interrupt_control(TX_INT_DISABLE);
+            if (!unitMutexCreated &&
+                tx_mutex_create(&unitMutex, const_cast<CHAR *>("Crc32"), TX_INHERIT) == TX_SUCCESS) {
+                unitMutexCreated = true;
+            }
+            tx_interrupt_control(interrupts);
+        }
+        // Waiting for a unit the thread holds itself would never end
+        if (unitMutexCreated && unitMutex.tx_mutex_owner != thread &&
+            tx_mutex_get(&unitMutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
+            unitLocked = true;
+        }
+    }
+#endif
+    if (unitInUse) {
+        releaseUnit();
+        return false;
+    }
+    unitInUse = true;
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->CR = CRC_CR_RESET;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Crc32::releaseUnit() {
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+    if (engine == Engine::HARDWARE) unitInUse = false;
+#ifndef LX_STANDALONE_ENABLE
+    if (unitLocked) {
+        unitLocked = false;
+        tx_mutex_put(&unitMutex);
+    }
+#endif
+#endif
+}
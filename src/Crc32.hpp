@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_CRC32_HPP
+#define LIBSMART_STM32LEVELX_CRC32_HPP
+
+#include <cstdint>
+#include <libsmart_config.hpp>
+#include <main.h>
+
+namespace Stm32LevelX {
+    /**
+     * @brief CRC-32/MPEG-2, as calculated by the CRC unit of the STM32.
+     *
+     * The data is processed in 32 bit words, in memory byte order. A trailing partial word is padded with 0xFF.
+     * If the device has a CRC unit, it is used. Otherwise, e.g. on a host, the same CRC is calculated in
+     * software. Define LIBSMART_STM32LEVELX_SOFTWARE_CRC to always use the software implementation.
+     *
+     * The CRC unit holds the state of the calculation, so a Crc32 claims it with the first word and keeps it
+     * until get(), reset() or the destructor. A thread that wants the unit while another thread holds it waits
+     * on a ThreadX mutex. If the unit cannot be waited for, because the caller is not a thread or already holds
+     * it with another Crc32, the calculation runs in software.
+     */
+    class Crc32 {
+    public:
+        Crc32() { reset(); }
+
+        ~Crc32();
+
+        Crc32(const Crc32 &) = delete;
+
+        Crc32 &operator=(const Crc32 &) = delete;
+
+        /**
+         * @brief Starts a new calculation.
+         */
+        void reset();
+
+        /**
+         * @brief Adds data to the calculation. The data may be split into calls of any size.
+         */
+        void update(const uint8_t *data, uint32_t size);
+
+        /**
+         * @brief Finishes the calculation and returns the CRC.
+         */
+        [[nodiscard]] uint32_t get();
+
+        /**
+         * @brief Returns true if the CRC unit is used while it is free.
+         */
+        [[nodiscard]] static constexpr bool isHardware() {
+#if defined(CRC) && defined(CRC_CR_RESET) && !defined(LIBSMART_STM32LEVELX_SOFTWARE_CRC)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+    protected:
+        enum class Engine : uint8_t {
+            NONE, ///< No word has been added since reset()
+            HARDWARE, ///< This Crc32 holds the CRC unit
+            SOFTWARE
+        };
+
+        void updateWord(uint32_t word);
+
+        /**
+         * @brief Takes the CRC unit and resets it.
+         *
+         * @return false if the unit is held by the calling thread or, outside of a thread, by anyone.
+         */
+        bool claimUnit();
+
+        void releaseUnit();
+
+        Engine engine = Engine::NONE;
+        bool unitLocked = false;
+        uint32_t crc = 0xFFFFFFFF;
+        uint32_t partial = 0;
+        uint8_t partialBytes = 0;
+    };
+}
+
+#endif
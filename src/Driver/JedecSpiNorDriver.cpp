@@ -0,0 +1,391 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "JedecSpiNorDriver.hpp"
+
+using namespace Stm32LevelX::Driver;
+using Stm32Common::HalStatus;
+
+ULONG JedecSpiNorDriver::getTotalSectors() {
+    return totalSize / getSectorSize();
+}
+
+ULONG JedecSpiNorDriver::getSectorSize() {
+    return eraseTypeCount > 0 ? eraseTypes[0].size : 4096;
+}
+
+UINT JedecSpiNorDriver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::read(0x%08x, %p, %lu)\r\n",
+                     addr, &out, size);
+
+    spi->lock();
+    spi->select();
+    auto ret = transmitReadHeader(addr);
+    for (size_t offset = 0; offset < size && ret == HalStatus::HAL_OK;) {
+        const auto sz = static_cast<uint16_t>(std::min(size - offset, static_cast<size_t>(MAX_TRANSFER_SIZE)));
+        ret = spi->receive(&out[offset], sz);
+        offset += sz;
+    }
+    spi->unselect();
+    spi->unlock();
+    return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+UINT JedecSpiNorDriver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::write(0x%08x, %p, %lu)\r\n",
+                     addr, &in, size);
+
+    for (size_t offset = 0; offset < size;) {
+        // A page program must not cross a page boundary
+        const uint32_t pageAddr = addr + offset;
+        const auto sz = static_cast<uint16_t>(std::min(size - offset,
+                                                       static_cast<size_t>(pageSize - pageAddr % pageSize)));
+        // Other threads must not access the device until the program has finished
+        spi->lock();
+        auto ret = WREN();
+        spi->select();
+        ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be((Instruction::PP << 24) | (pageAddr & 0x00FFFFFF));
+        ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(&in[offset], sz);
+        spi->unselect();
+        ret = ret != HalStatus::HAL_OK ? ret : waitForReady(DEFAULT_PROGRAM_TIMEOUT_MS);
+        spi->unlock();
+        if (ret != HalStatus::HAL_OK) return LX_ERROR;
+        offset += sz;
+    }
+
+    // Read everything back in one transaction
+    uint8_t buffer[VERIFY_CHUNK_SIZE];
+    bool equal = true;
+    spi->lock();
+    spi->select();
+    auto ret = transmitReadHeader(addr);
+    for (size_t offset = 0; offset < size && equal && ret == HalStatus::HAL_OK; offset += VERIFY_CHUNK_SIZE) {
+        const auto sz = static_cast<uint16_t>(std::min(size - offset, static_cast<size_t>(VERIFY_CHUNK_SIZE)));
+        ret = spi->receive(buffer, sz);
+        equal = ret == HalStatus::HAL_OK && std::memcmp(buffer, &in[offset], sz) == 0;
+    }
+    spi->unselect();
+    spi->unlock();
+
+    if (ret != HalStatus::HAL_OK) return LX_ERROR;
+    return equal ? LX_SUCCESS : LX_INVALID_WRITE;
+}
+
+UINT JedecSpiNorDriver::eraseSector(const uint32_t addr, ULONG erase_count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::eraseSector(0x%08x)\r\n",
+                     addr);
+
+    if (eraseTypeCount == 0 || addr % eraseTypes[0].size > 0) return LX_ERROR;
+    const auto ret = erase(eraseTypes[0].opcode, addr, eraseTimeouts_ms[0]);
+    return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+UINT JedecSpiNorDriver::eraseRange(const uint32_t addr, const uint32_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::eraseRange(0x%08x, %lu)\r\n",
+                     addr, size);
+
+    if (eraseTypeCount == 0) return LX_ERROR;
+    const uint32_t sectorSize = eraseTypes[0].size;
+    if (addr % sectorSize > 0 || size % sectorSize > 0 || addr > totalSize || size > totalSize - addr) {
+        return LX_ERROR;
+    }
+
+    if (addr == 0 && size == totalSize) {
+        const auto ret = erase(Instruction::CE, 0, chipEraseTimeout_ms);
+        return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+    }
+
+    uint32_t offset = addr;
+    while (offset < addr + size) {
+        // Largest erase type that is aligned and fits into the rest of the range
+        uint8_t type = eraseTypeCount - 1;
+        while (type > 0 && (offset % eraseTypes[type].size > 0 || addr + size - offset < eraseTypes[type].size)) {
+            type--;
+        }
+        const auto ret = erase(eraseTypes[type].opcode, offset, eraseTimeouts_ms[type]);
+        if (ret != HalStatus::HAL_OK) return LX_ERROR;
+        offset += eraseTypes[type].size;
+    }
+    return LX_SUCCESS;
+}
+
+UINT JedecSpiNorDriver::verifySectorErased(const uint32_t addr) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::verifySectorErased(0x%08x)\r\n",
+                     addr);
+
+    const ULONG sectorSize = getSectorSize();
+    if (addr % sectorSize > 0) return LX_ERROR;
+
+    uint8_t buffer[VERIFY_CHUNK_SIZE];
+    bool erased = true;
+    spi->lock();
+    spi->select();
+    auto ret = transmitReadHeader(addr);
+    for (uint32_t offset = 0; offset < sectorSize && erased && ret == HalStatus::HAL_OK; offset += VERIFY_CHUNK_SIZE) {
+        ret = spi->receive(buffer, VERIFY_CHUNK_SIZE);
+        for (uint16_t i = 0; i < VERIFY_CHUNK_SIZE && erased; i++) erased = buffer[i] == 0xFF;
+    }
+    // Ends the read early on the first programmed bit
+    spi->unselect();
+    spi->unlock();
+    return ret == HalStatus::HAL_OK && erased ? LX_SUCCESS : LX_ERROR;
+}
+
+UINT JedecSpiNorDriver::initialize() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::initialize()\r\n");
+
+    // No other thread may access the device while it is reset and configured
+    spi->lock();
+    reset();
+    if (sfdp.read(spi) != HalStatus::HAL_OK || sfdp.getDensity() == 0) {
+        spi->unlock();
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::initialize() no BFPT\r\n");
+        return LX_ERROR;
+    }
+    if (unprotect() != HalStatus::HAL_OK) {
+        spi->unlock();
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::initialize() write protection not removed\r\n");
+        return LX_ERROR;
+    }
+    configure();
+    spi->unlock();
+    if (eraseTypeCount == 0) return LX_ERROR;
+
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::initialize() id=0x%02x size=%lu read=0x%02x (1-%d-%d)\r\n",
+                     manufacturerId, totalSize, readCommand.opcode, readCommand.addressLanes, readCommand.dataLanes);
+    return LX_SUCCESS;
+}
+
+UINT JedecSpiNorDriver::reset() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::JedecSpiNorDriver::reset()\r\n");
+
+    spi->lock();
+    auto ret = transmitInstruction(Instruction::RSTEN);
+    ret = ret != HalStatus::HAL_OK ? ret : transmitInstruction(Instruction::RST);
+    // tRST is below 1 ms on all supported devices
+    delay(1);
+    spi->unlock();
+    return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+bool JedecSpiNorDriver::isBusy() {
+    uint8_t status = 0;
+    if (flagStatusPolling) {
+        // Bit 7 of the flag status register is set when the device is ready
+        return readStatus(Instruction::RDFSR, status) != HalStatus::HAL_OK || (status & 1 << 7) == 0;
+    }
+    return readStatus(Instruction::RDSR, status) != HalStatus::HAL_OK || (status & 1 << 0) > 0;
+}
+
+HalStatus JedecSpiNorDriver::waitForReady(const uint32_t timeout_ms) {
+    const uint32_t start_ms = millis();
+    while (isBusy()) {
+        delay(1);
+        if ((timeout_ms > 0) && (millis() - start_ms > timeout_ms)) return HalStatus::HAL_TIMEOUT;
+    }
+    return HalStatus::HAL_OK;
+}
+
+HalStatus JedecSpiNorDriver::readStatus(const uint8_t instruction, uint8_t &value) {
+    spi->lock();
+    spi->select();
+    auto ret = spi->transmit(instruction);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->receive(&value, 1);
+    spi->unselect();
+    spi->unlock();
+    return ret;
+}
+
+void JedecSpiNorDriver::configure() {
+    totalSize = std::min(sfdp.getDensity(), MAX_3BYTE_SIZE);
+    pageSize = sfdp.getPageSize();
+    flagStatusPolling = sfdp.isFlagStatusPolling();
+    const uint32_t chipEraseTime_ms = sfdp.getChipEraseTime_ms();
+    chipEraseTimeout_ms = chipEraseTime_ms > 0 ? chipEraseTime_ms : DEFAULT_CHIP_ERASE_TIMEOUT_MS;
+
+    // Erase types sorted by size
+    eraseTypeCount = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        const auto eraseType = sfdp.getEraseType(i);
+        if (eraseType.size == 0 || eraseType.size > totalSize) continue;
+        const uint32_t eraseTime_ms = sfdp.getEraseTime_ms(i);
+        uint8_t position = eraseTypeCount++;
+        for (; position > 0 && eraseTypes[position - 1].size > eraseType.size; position--) {
+            eraseTypes[position] = eraseTypes[position - 1];
+            eraseTimeouts_ms[position] = eraseTimeouts_ms[position - 1];
+        }
+        eraseTypes[position] = eraseType;
+        eraseTimeouts_ms[position] = eraseTime_ms > 0 ? eraseTime_ms : DEFAULT_ERASE_TIMEOUT_MS;
+    }
+    if (eraseTypeCount == 0 && sfdp.get4KEraseOpcode() != 0) {
+        eraseTypes[0] = {4096, sfdp.get4KEraseOpcode()};
+        eraseTimeouts_ms[0] = DEFAULT_ERASE_TIMEOUT_MS;
+        eraseTypeCount = 1;
+    }
+    // With a sector map the larger erase types depend on the address, the smallest one is uniform
+    if (sfdp.hasParameterTable(Sfdp::SECTOR_MAP_ID)) eraseTypeCount = std::min(eraseTypeCount, static_cast<uint8_t>(1));
+
+    // Fastest read instruction the transport can drive
+    using FastReadMode = Sfdp::FastReadMode;
+    readCommand = {Instruction::FAST_READ, 1, 1, 1};
+    quadEnabled = false;
+    for (const auto mode: {
+             FastReadMode::FAST_READ_1_4_4, FastReadMode::FAST_READ_1_1_4,
+             FastReadMode::FAST_READ_1_2_2, FastReadMode::FAST_READ_1_1_2
+         }) {
+        const auto fastRead = sfdp.getFastRead(mode);
+        if (fastRead.opcode == 0 || fastRead.dataLanes > spi->getMaxLanes()) continue;
+        // The transport sends whole bytes
+        const uint16_t dummyBits = (fastRead.modeClocks + fastRead.waitStates) * fastRead.addressLanes;
+        if (dummyBits % 8 > 0) continue;
+        if (fastRead.dataLanes == 4 && !quadEnabled) {
+            if (enableQuad(sfdp.getQuadEnableRequirements()) != HalStatus::HAL_OK) continue;
+            quadEnabled = true;
+        }
+        readCommand = {
+            fastRead.opcode, fastRead.addressLanes, fastRead.dataLanes, static_cast<uint8_t>(dummyBits / 8)
+        };
+        return;
+    }
+}
+
+HalStatus JedecSpiNorDriver::unprotect() {
+    uint8_t id[3] = {};
+    spi->lock();
+    spi->select();
+    auto ret = spi->transmit(Instruction::RDID);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->receive(id, sizeof(id));
+    spi->unselect();
+    spi->unlock();
+    if (ret != HalStatus::HAL_OK) return ret;
+    manufacturerId = id[0];
+
+    if (manufacturerId == Manufacturer::SST) {
+        // The block protection register of the SST26 protects all blocks after power-up
+        ret = WREN();
+        return ret != HalStatus::HAL_OK ? ret : transmitInstruction(Instruction::ULBPR);
+    }
+
+    const uint8_t mask = manufacturerId == Manufacturer::MICRON ? BLOCK_PROTECT_BITS_MICRON : BLOCK_PROTECT_BITS;
+    uint8_t status[2] = {};
+    ret = readStatus(Instruction::RDSR, status[0]);
+    if (ret != HalStatus::HAL_OK || (status[0] & mask) == 0) return ret;
+    status[0] &= ~mask;
+    const uint8_t requirements = sfdp.getBfptDwords() >= 15 ? sfdp.getQuadEnableRequirements() : 0;
+    if (requirements == 1 || requirements == 4 || requirements == 5) {
+        // Status register 2 is written as the second byte of WRSR, a single byte may clear it
+        ret = readStatus(Instruction::RDSR2, status[1]);
+        return ret != HalStatus::HAL_OK ? ret : writeStatus(Instruction::WRSR, status, 2);
+    }
+    return writeStatus(Instruction::WRSR, status, 1);
+}
+
+HalStatus JedecSpiNorDriver::enableQuad(const uint8_t requirements) {
+    // Tables before JESD216A do not tell how to set the QE bit
+    if (sfdp.getBfptDwords() < 15) return HalStatus::HAL_ERROR;
+
+    uint8_t status[2] = {};
+    HalStatus ret;
+    switch (requirements) {
+        case 0:
+            // No QE bit
+            return HalStatus::HAL_OK;
+        case 1:
+        case 4:
+        case 5:
+            // QE is bit 1 of status register 2, written as the second byte of WRSR
+            ret = readStatus(Instruction::RDSR, status[0]);
+            ret = ret != HalStatus::HAL_OK ? ret : readStatus(Instruction::RDSR2, status[1]);
+            if (ret != HalStatus::HAL_OK || (status[1] & 1 << 1) > 0) return ret;
+            status[1] |= 1 << 1;
+            return writeStatus(Instruction::WRSR, status, 2);
+        case 2:
+            // QE is bit 6 of status register 1
+            ret = readStatus(Instruction::RDSR, status[0]);
+            if (ret != HalStatus::HAL_OK || (status[0] & 1 << 6) > 0) return ret;
+            status[0] |= 1 << 6;
+            return writeStatus(Instruction::WRSR, status, 1);
+        case 3:
+            // QE is bit 7 of status register 2, which has its own instructions
+            ret = readStatus(Instruction::RDSR2_QER3, status[0]);
+            if (ret != HalStatus::HAL_OK || (status[0] & 1 << 7) > 0) return ret;
+            status[0] |= 1 << 7;
+            return writeStatus(Instruction::WRSR2_QER3, status, 1);
+        case 6:
+            // QE is bit 1 of status register 2, written with 0x31
+            ret = readStatus(Instruction::RDSR2, status[0]);
+            if (ret != HalStatus::HAL_OK || (status[0] & 1 << 1) > 0) return ret;
+            status[0] |= 1 << 1;
+            return writeStatus(Instruction::WRSR2, status, 1);
+        default:
+            return HalStatus::HAL_ERROR;
+    }
+}
+
+HalStatus JedecSpiNorDriver::writeStatus(const uint8_t instruction, const uint8_t *value, const uint16_t size) {
+    spi->lock();
+    auto ret = WREN();
+    spi->select();
+    ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(instruction);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(value, size);
+    spi->unselect();
+    // Non-volatile status register writes take up to 15 ms
+    ret = ret != HalStatus::HAL_OK ? ret : waitForReady(50);
+    spi->unlock();
+    return ret;
+}
+
+HalStatus JedecSpiNorDriver::transmitInstruction(const uint8_t instruction) {
+    spi->lock();
+    spi->select();
+    const auto ret = spi->transmit(instruction);
+    spi->unselect();
+    spi->unlock();
+    return ret;
+}
+
+HalStatus JedecSpiNorDriver::transmitReadHeader(const uint32_t addr) {
+    // 3 address bytes, followed by mode and dummy bytes sent as 0xFF. Up to 38 clocks on 4 lanes.
+    uint8_t header[3 + 19];
+    header[0] = addr >> 16;
+    header[1] = addr >> 8;
+    header[2] = addr;
+    const uint8_t dummyBytes = std::min(readCommand.dummyBytes, static_cast<uint8_t>(sizeof(header) - 3));
+    std::memset(&header[3], 0xFF, dummyBytes);
+
+    auto ret = spi->transmit(readCommand.opcode);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->setLanes(readCommand.addressLanes);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(header, 3 + dummyBytes);
+    return ret != HalStatus::HAL_OK ? ret : spi->setLanes(readCommand.dataLanes);
+}
+
+HalStatus JedecSpiNorDriver::erase(const uint8_t opcode, const uint32_t addr, const uint32_t timeout_ms) {
+    // Other threads must not access the device until the erase has finished
+    spi->lock();
+    auto ret = WREN();
+    spi->select();
+    if (ret == HalStatus::HAL_OK) {
+        ret = opcode == Instruction::CE
+                  ? spi->transmit(opcode)
+                  : spi->transmit_be(static_cast<uint32_t>(opcode) << 24 | (addr & 0x00FFFFFF));
+    }
+    spi->unselect();
+    ret = ret != HalStatus::HAL_OK ? ret : waitForReady(timeout_ms);
+    spi->unlock();
+    return ret;
+}
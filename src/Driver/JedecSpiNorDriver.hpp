@@ -0,0 +1,238 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_JEDECSPINORDRIVER_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_JEDECSPINORDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "../AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+#include "Sfdp.hpp"
+#include "Transport/AbstractSpiTransport.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Driver for SPI NOR flash devices that describe themselves with SFDP (JESD216).
+     *
+     * initialize() reads the BFPT and configures the driver from it: the fastest read instruction the transport
+     * can drive, the erase instructions, the page size, the size of the array and how the device is polled
+     * while it is busy. The driver works with parts like the Winbond W25Q, Macronix MX25 and Microchip SST26
+     * families. initialize() also removes the write protection: SST26 parts power up with all blocks protected
+     * and are unlocked with ULBPR, other parts get the block protect bits of their status register cleared.
+     *
+     * Every transaction, and every program or erase together with the polling for its end, holds the lock of
+     * the transport, so the driver can share the bus with other threads.
+     *
+     * If the SFDP header lists a sector map parameter table, the erase types are not uniform over the array,
+     * and only the smallest erase type is used. Devices larger than 16 MByte are used with 3 byte addresses,
+     * i.e. only their first 16 MByte.
+     */
+    class JedecSpiNorDriver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
+    public:
+        explicit JedecSpiNorDriver(AbstractSpiTransport *spi)
+            : spi(spi) { ; }
+
+        JedecSpiNorDriver(AbstractSpiTransport *spi, Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              spi(spi) { ; }
+
+        class Instruction {
+        public:
+            static constexpr uint8_t WRSR = 0x01; ///< Write Status Register
+            static constexpr uint8_t PP = 0x02; ///< Page Program
+            static constexpr uint8_t WRDI = 0x04; ///< Write Disable
+            static constexpr uint8_t RDSR = 0x05; ///< Read Status Register
+            static constexpr uint8_t WREN = 0x06; ///< Write Enable
+            static constexpr uint8_t FAST_READ = 0x0B; ///< Read with 8 dummy clocks
+            static constexpr uint8_t RDSR2 = 0x35; ///< Read Status Register 2
+            static constexpr uint8_t WRSR2 = 0x31; ///< Write Status Register 2 (QER 6)
+            static constexpr uint8_t WRSR2_QER3 = 0x3E; ///< Write Status Register 2 (QER 3)
+            static constexpr uint8_t RDSR2_QER3 = 0x3F; ///< Read Status Register 2 (QER 3)
+            static constexpr uint8_t RSTEN = 0x66; ///< Reset Enable
+            static constexpr uint8_t RDFSR = 0x70; ///< Read Flag Status Register
+            static constexpr uint8_t ULBPR = 0x98; ///< Global Block Protection Unlock (SST26)
+            static constexpr uint8_t RST = 0x99; ///< Reset Memory
+            static constexpr uint8_t RDID = 0x9F; ///< JEDEC-ID Read
+            static constexpr uint8_t CE = 0xC7; ///< Chip Erase
+        };
+
+        /**
+         * JEDEC manufacturer IDs that need their own handling.
+         */
+        class Manufacturer {
+        public:
+            static constexpr uint8_t MICRON = 0x20;
+            static constexpr uint8_t SST = 0xBF;
+        };
+
+        /**
+         * Block protect bits of status register 1: BP0 to BP3 (or BP0 to BP2 and TB) in bits 2 to 5, and BP3 in
+         * bit 6 on Micron parts. Bit 6 is QE on Macronix parts, so it is only cleared on Micron parts.
+         */
+        static constexpr uint8_t BLOCK_PROTECT_BITS = 0x3C;
+        static constexpr uint8_t BLOCK_PROTECT_BITS_MICRON = 0x7C;
+
+        /**
+         * @brief Read instruction chosen by initialize().
+         */
+        struct ReadCommand {
+            uint8_t opcode;
+            uint8_t addressLanes; ///< Lanes of the address, mode and dummy bytes
+            uint8_t dataLanes;
+            uint8_t dummyBytes; ///< Mode and dummy clocks, in bytes on the address lanes
+        };
+
+        /**
+         * Sizes of the array beyond this need 4 byte addresses, which the driver does not use.
+         */
+        static constexpr uint32_t MAX_3BYTE_SIZE = 16 * 1024 * 1024;
+
+        /**
+         * Bytes read at a time while programmed data or erased sectors are compared.
+         */
+        static constexpr uint16_t VERIFY_CHUNK_SIZE = 64;
+
+        /**
+         * Largest data phase handed to the transport at once. Longer reads continue in the same transaction.
+         */
+        static constexpr uint16_t MAX_TRANSFER_SIZE = 0x8000;
+
+        /**
+         * Timeouts if the BFPT does not specify the times.
+         */
+        static constexpr uint32_t DEFAULT_PROGRAM_TIMEOUT_MS = 10;
+        static constexpr uint32_t DEFAULT_ERASE_TIMEOUT_MS = 2000;
+        static constexpr uint32_t DEFAULT_CHIP_ERASE_TIMEOUT_MS = 400000;
+
+        [[nodiscard]] const Sfdp &getSfdp() const { return sfdp; }
+
+        [[nodiscard]] const ReadCommand &getReadCommand() const { return readCommand; }
+
+        [[nodiscard]] uint32_t getTotalSize() const { return totalSize; }
+
+        [[nodiscard]] uint32_t getPageSize() const { return pageSize; }
+
+        /**
+         * @brief Returns an erase type the driver uses, sorted from the smallest to the largest.
+         *
+         * @return Size 0 if there are less erase types.
+         */
+        [[nodiscard]] Sfdp::EraseType getEraseType(const uint8_t index) const {
+            return index < eraseTypeCount ? eraseTypes[index] : Sfdp::EraseType{};
+        }
+
+        [[nodiscard]] bool isQuadEnabled() const { return quadEnabled; }
+
+        [[nodiscard]] bool isFlagStatusPolling() const { return flagStatusPolling; }
+
+        /**
+         * @brief Returns the JEDEC manufacturer ID read by initialize().
+         */
+        [[nodiscard]] uint8_t getManufacturerId() const { return manufacturerId; }
+
+        /**
+         * @brief Returns true if the device is busy with a program or erase.
+         */
+        [[nodiscard]] bool isBusy();
+
+        /**
+         * @brief Polls the device until it has finished a program or erase.
+         *
+         * @param timeout_ms 0 to wait forever.
+         */
+        Stm32Common::HalStatus waitForReady(uint32_t timeout_ms);
+
+        Stm32Common::HalStatus readStatus(uint8_t instruction, uint8_t &value);
+
+        Stm32Common::HalStatus WREN() { return transmitInstruction(Instruction::WREN); }
+
+        Stm32Common::HalStatus WRDI() { return transmitInstruction(Instruction::WRDI); }
+
+        ULONG getTotalSectors() override;
+
+        /**
+         * @brief Returns the size of the smallest erase type, which is the sector size for LevelX.
+         */
+        ULONG getSectorSize() override;
+
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+        /**
+         * @brief Programs the data page by page and reads it back.
+         *
+         * @return LX_SUCCESS, LX_INVALID_WRITE if the data could not be read back, or LX_ERROR.
+         */
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
+
+        UINT eraseSector(uint32_t addr, ULONG erase_count) override;
+
+        /**
+         * @brief Erases a range with the largest erase types that fit, or with a chip erase for the whole array.
+         */
+        UINT eraseRange(uint32_t addr, uint32_t size) override;
+
+        UINT verifySectorErased(uint32_t addr) override;
+
+        /**
+         * @brief Resets the device, reads the SFDP tables, removes the write protection and configures the driver.
+         *
+         * @return LX_ERROR if the device has no valid BFPT or the protection could not be removed.
+         */
+        UINT initialize() override;
+
+        UINT reset() override;
+
+    protected:
+        /**
+         * @brief Chooses the read instruction, the erase types, the page size and the busy polling from the BFPT.
+         */
+        void configure();
+
+        /**
+         * @brief Removes the write protection, with ULBPR on SST26 parts and by clearing the block protect bits
+         * on other parts.
+         *
+         * Called before configure(), so enableQuad() sees the final status register.
+         */
+        Stm32Common::HalStatus unprotect();
+
+        /**
+         * @brief Sets the QE bit as described by the Quad Enable Requirements of the BFPT.
+         */
+        Stm32Common::HalStatus enableQuad(uint8_t requirements);
+
+        /**
+         * @brief Writes a status register and waits until the device has stored it.
+         */
+        Stm32Common::HalStatus writeStatus(uint8_t instruction, const uint8_t *value, uint16_t size);
+
+        Stm32Common::HalStatus transmitInstruction(uint8_t instruction);
+
+        /**
+         * @brief Sends the read instruction, address and dummy bytes and switches to the data lanes.
+         */
+        Stm32Common::HalStatus transmitReadHeader(uint32_t addr);
+
+        Stm32Common::HalStatus erase(uint8_t opcode, uint32_t addr, uint32_t timeout_ms);
+
+        AbstractSpiTransport *spi;
+        Sfdp sfdp;
+        ReadCommand readCommand = {Instruction::FAST_READ, 1, 1, 1};
+        Sfdp::EraseType eraseTypes[4] = {};
+        uint32_t eraseTimeouts_ms[4] = {};
+        uint8_t eraseTypeCount = 0;
+        uint32_t chipEraseTimeout_ms = DEFAULT_CHIP_ERASE_TIMEOUT_MS;
+        uint32_t totalSize = 0;
+        uint32_t pageSize = 256;
+        bool quadEnabled = false;
+        bool flagStatusPolling = false;
+        uint8_t manufacturerId = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include "PartitionNorDriver.hpp"
+
+using namespace Stm32LevelX::Driver;
+
+namespace {
+#ifndef LX_STANDALONE_ENABLE
+    TX_MUTEX devicesMutex = {};
+    volatile bool devicesMutexCreated = false;
+#endif
+
+    /**
+     * @brief Gets the mutex of PartitionNorDriver::initializedDevices, outside of a thread there is nothing to lock.
+     */
+    bool lockDevices() {
+#ifndef LX_STANDALONE_ENABLE
+        if (tx_thread_identify() == TX_NULL) return false;
+        if (!devicesMutexCreated) {
+            const UINT interrupts = tx_interrupt_control(TX_INT_DISABLE);
+            if (!devicesMutexCreated &&
+                tx_mutex_create(&devicesMutex, const_cast<CHAR *>("PartitionNorDriver"), TX_INHERIT) == TX_SUCCESS) {
+                devicesMutexCreated = true;
+            }
+            tx_interrupt_control(interrupts);
+        }
+        return devicesMutexCreated && tx_mutex_get(&devicesMutex, TX_WAIT_FOREVER) == TX_SUCCESS;
+#else
+        return false;
+#endif
+    }
+
+    void unlockDevices([[maybe_unused]] const bool locked) {
+#ifndef LX_STANDALONE_ENABLE
+        if (locked) tx_mutex_put(&devicesMutex);
+#endif
+    }
+}
+
+ULONG PartitionNorDriver::getTotalSectors() {
+    return totalSectors;
+}
+
+ULONG PartitionNorDriver::getSectorSize() {
+    return sectorSize;
+}
+
+ULONG *PartitionNorDriver::getBaseAddress() {
+    ULONG *base = driver->getBaseAddress();
+    if (base == nullptr) return nullptr;
+    return base + partition.offset / sizeof(ULONG);
+}
+
+UINT PartitionNorDriver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::read(0x%08x, %p, %lu)\r\n",
+                     addr, &out, size);
+
+    if (!contains(addr, size)) return LX_ERROR;
+    return driver->read(partition.offset + addr, out, size);
+}
+
+UINT PartitionNorDriver::readv(const Segment *segments, const size_t count) {
+    return forward(segments, count, false);
+}
+
+UINT PartitionNorDriver::readAsync(const uint32_t addr, uint8_t *out, const size_t size,
+                                   const ReadCallback callback, void *context) {
+    if (!contains(addr, size)) return LX_ERROR;
+    return driver->readAsync(partition.offset + addr, out, size, callback, context);
+}
+
+UINT PartitionNorDriver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::write(0x%08x, %p, %lu)\r\n",
+                     addr, &in, size);
+
+    if (!contains(addr, size)) return LX_ERROR;
+    return driver->write(partition.offset + addr, in, size);
+}
+
+UINT PartitionNorDriver::writev(const Segment *segments, const size_t count) {
+    return forward(segments, count, true);
+}
+
+UINT PartitionNorDriver::eraseSector(const uint32_t addr, const ULONG erase_count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::eraseSector(0x%08x)\r\n",
+                     addr);
+
+    if (!contains(addr, sectorSize)) return LX_ERROR;
+    return driver->eraseSector(partition.offset + addr, erase_count);
+}
+
+UINT PartitionNorDriver::eraseRange(const uint32_t addr, const uint32_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::eraseRange(0x%08x, %lu)\r\n",
+                     addr, size);
+
+    if (!contains(addr, size)) return LX_ERROR;
+    // The device only uses erase commands that fit into the range, so the other partitions stay intact
+    return driver->eraseRange(partition.offset + addr, size);
+}
+
+UINT PartitionNorDriver::startWrite(const uint32_t addr, uint8_t *in, const size_t size) {
+    if (!contains(addr, size)) return LX_ERROR;
+    return driver->startWrite(partition.offset + addr, in, size);
+}
+
+UINT PartitionNorDriver::startEraseSector(const uint32_t addr, const ULONG erase_count) {
+    if (!contains(addr, sectorSize)) return LX_ERROR;
+    return driver->startEraseSector(partition.offset + addr, erase_count);
+}
+
+UINT PartitionNorDriver::finish() {
+    return driver->finish();
+}
+
+UINT PartitionNorDriver::verifySectorErased(const uint32_t addr) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::verifySectorErased(0x%08x)\r\n",
+                     addr);
+
+    if (!contains(addr, sectorSize)) return LX_ERROR;
+    return driver->verifySectorErased(partition.offset + addr);
+}
+
+UINT PartitionNorDriver::initialize() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::initialize()\r\n");
+
+    sectorSize = 0;
+    totalSectors = 0;
+
+    const UINT ret = initializeDevice();
+    if (ret != LX_SUCCESS) return ret;
+
+    const ULONG deviceSectorSize = driver->getSectorSize();
+    const ULONG deviceSectors = driver->getTotalSectors();
+    if (deviceSectorSize == 0 || partition.offset % deviceSectorSize > 0 ||
+        partition.offset / deviceSectorSize >= deviceSectors) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::PartitionNorDriver::initialize() invalid offset 0x%08x\r\n",
+                         partition.offset);
+        return LX_ERROR;
+    }
+
+    const ULONG available = deviceSectors - partition.offset / deviceSectorSize;
+    const ULONG sectors = partition.sectors == 0 ? available : partition.sectors;
+    if (sectors > available) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::PartitionNorDriver::initialize() %lu sectors, %lu available\r\n",
+                         sectors, available);
+        return LX_ERROR;
+    }
+
+    sectorSize = deviceSectorSize;
+    totalSectors = sectors;
+    return LX_SUCCESS;
+}
+
+UINT PartitionNorDriver::initializeDevice() {
+    const bool locked = lockDevices();
+    for (const auto device: initializedDevices) {
+        if (device == driver) {
+            unlockDevices(locked);
+            return LX_SUCCESS;
+        }
+    }
+
+    const UINT ret = driver->initialize();
+    if (ret != LX_SUCCESS) {
+        unlockDevices(locked);
+        return ret;
+    }
+    for (auto &device: initializedDevices) {
+        if (device == nullptr) {
+            device = driver;
+            unlockDevices(locked);
+            return LX_SUCCESS;
+        }
+    }
+    unlockDevices(locked);
+    LIBSMART_STM32LEVELX_LOG(log(), WARNING)
+            ->printf("Stm32LevelX::Driver::PartitionNorDriver::initialize() more than %u devices\r\n", MAX_DEVICES);
+    return LX_SUCCESS;
+}
+
+UINT PartitionNorDriver::reset() {
+    forgetDevice(driver);
+    return driver->reset();
+}
+
+void PartitionNorDriver::forgetDevice(const AbstractNorDriver *device) {
+    const bool locked = lockDevices();
+    for (auto &initialized: initializedDevices) {
+        if (initialized == device) initialized = nullptr;
+    }
+    unlockDevices(locked);
+}
+
+bool PartitionNorDriver::contains(const uint32_t addr, const size_t size) const {
+    const uint64_t partitionSize = static_cast<uint64_t>(totalSectors) * sectorSize;
+    return addr <= partitionSize && size <= partitionSize - addr;
+}
+
+UINT PartitionNorDriver::forward(const Segment *segments, const size_t count, const bool write) {
+    Segment translated[SEGMENT_BATCH];
+    for (size_t first = 0; first < count; first += SEGMENT_BATCH) {
+        const size_t n = std::min(count - first, SEGMENT_BATCH);
+        for (size_t i = 0; i < n; i++) {
+            const Segment &segment = segments[first + i];
+            if (!contains(segment.addr, segment.size)) return LX_ERROR;
+            translated[i] = {partition.offset + segment.addr, segment.data, segment.size};
+        }
+        const UINT ret = write ? driver->writev(translated, n) : driver->readv(translated, n);
+        if (ret != LX_SUCCESS) return ret;
+    }
+    return LX_SUCCESS;
+}
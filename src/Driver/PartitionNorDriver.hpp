@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_PARTITIONNORDRIVER_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_PARTITIONNORDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "../AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Driver for a range of sectors of another driver, so one device can hold several LevelX volumes.
+     *
+     * Every partition has its own LevelXNorFlash, which only sees the sectors of the partition at addresses
+     * starting at 0. Accesses outside of the partition fail with LX_ERROR, so the garbage collection of one
+     * volume never erases or programs the sectors of another one.
+     *
+     * The partitions share the device, so the device driver must serialize its transactions if the volumes are
+     * used from different threads, like Sst26Driver does. Only the first initialize() of a partition initializes
+     * the device, the following ones only check the range of their partition. Opening or formatting one volume
+     * thus does not reset the device while another volume erases or programs it. reset() resets the device, so
+     * the next initialize() of any of its partitions initializes it again.
+     */
+    class PartitionNorDriver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
+    public:
+        /**
+         * @brief Location of a partition on the device.
+         */
+        struct Partition {
+            uint32_t offset; ///< Start address on the device, aligned to the sector size of the device
+            ULONG sectors; ///< Number of sectors, 0 for all sectors up to the end of the device
+        };
+
+        PartitionNorDriver(AbstractNorDriver *driver, const Partition &partition)
+            : driver(driver), partition(partition) { ; }
+
+        PartitionNorDriver(AbstractNorDriver *driver, const Partition &partition,
+                           Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              driver(driver), partition(partition) { ; }
+
+        [[nodiscard]] const Partition &getPartition() const { return partition; }
+
+        ULONG getTotalSectors() override;
+
+        ULONG getSectorSize() override;
+
+        /**
+         * @brief Returns the address of the partition, if the device is memory mapped.
+         */
+        ULONG *getBaseAddress() override;
+
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+        UINT readv(const Segment *segments, size_t count) override;
+
+        UINT readAsync(uint32_t addr, uint8_t *out, size_t size, ReadCallback callback, void *context) override;
+
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
+
+        UINT writev(const Segment *segments, size_t count) override;
+
+        UINT eraseSector(uint32_t addr, ULONG erase_count) override;
+
+        UINT eraseRange(uint32_t addr, uint32_t size) override;
+
+        UINT startWrite(uint32_t addr, uint8_t *in, size_t size) override;
+
+        UINT startEraseSector(uint32_t addr, ULONG erase_count) override;
+
+        UINT finish() override;
+
+        UINT verifySectorErased(uint32_t addr) override;
+
+        /**
+         * @brief Initializes the device, unless a partition of it has done so before, and checks that the
+         *        partition fits on it.
+         *
+         * @return LX_ERROR if the device fails, the offset is not aligned to a sector or the partition ends beyond
+         *         the device.
+         */
+        UINT initialize() override;
+
+        /**
+         * @brief Resets the device and forgets that it was initialized.
+         */
+        UINT reset() override;
+
+        /**
+         * @brief Forgets that the device was initialized, so the next initialize() of one of its partitions
+         *        initializes it again.
+         *
+         * Call it when the device lost its state, after a power cycle for example, and before its driver is destroyed.
+         */
+        static void forgetDevice(const AbstractNorDriver *device);
+
+    protected:
+        /**
+         * Segments translated at once by readv() and writev().
+         */
+        static constexpr size_t SEGMENT_BATCH = 8;
+
+        /**
+         * Devices that are remembered as initialized. The partitions of further devices initialize them every time.
+         * Partitions of different threads access it under a mutex.
+         */
+        static constexpr uint8_t MAX_DEVICES = 4;
+        static AbstractNorDriver *initializedDevices[MAX_DEVICES];
+
+        /**
+         * @brief Initializes the device if it is not in initializedDevices, and adds it.
+         *
+         * Holds the mutex of initializedDevices during the initialization, so partitions that are initialized by
+         * two threads at once do not both initialize the device.
+         */
+        UINT initializeDevice();
+
+        /**
+         * @brief Returns true if [addr, addr + size) is inside of the partition.
+         */
+        [[nodiscard]] bool contains(uint32_t addr, size_t size) const;
+
+        /**
+         * @brief Translates the segments to device addresses and passes them to readv() or writev() of the device.
+         */
+        UINT forward(const Segment *segments, size_t count, bool write);
+
+        AbstractNorDriver *driver;
+        Partition partition;
+        ULONG sectorSize = 0;
+        ULONG totalSectors = 0;
+    };
+
+    inline AbstractNorDriver *PartitionNorDriver::initializedDevices[MAX_DEVICES] = {};
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "Sfdp.hpp"
+
+using namespace Stm32LevelX::Driver;
+using Stm32Common::HalStatus;
+
+HalStatus Sfdp::read(AbstractSpiTransport *spi) {
+    return load(readDevice, spi);
+}
+
+bool Sfdp::parse(const uint8_t *image, const uint32_t size) {
+    Image context = {image, size};
+    return load(readImage, &context) == HalStatus::HAL_OK;
+}
+
+uint32_t Sfdp::getDensity() const {
+    const uint32_t dword = getDword(2);
+    if (dword == 0) return 0;
+    // Bit 31 set: the array has 2^N bits, otherwise N + 1 bits
+    if ((dword & 1UL << 31) > 0) {
+        const uint32_t exponent = dword & 0x7FFFFFFF;
+        return exponent >= 3 && exponent < 35 ? static_cast<uint32_t>((1ULL << exponent) / 8) : 0;
+    }
+    return static_cast<uint32_t>((static_cast<uint64_t>(dword) + 1) / 8);
+}
+
+uint32_t Sfdp::getPageSize() const {
+    if (bfptDwords < 11) return isValid() ? 256 : 0;
+    return 1UL << ((getDword(11) >> 4) & 0x0F);
+}
+
+Sfdp::EraseType Sfdp::getEraseType(const uint8_t index) const {
+    if (index >= 4) return {};
+    const uint32_t dword = getDword(8 + index / 2) >> (index % 2 * 16);
+    const uint8_t exponent = dword & 0xFF;
+    if (exponent == 0 || exponent >= 32) return {};
+    return {static_cast<uint32_t>(1UL << exponent), static_cast<uint8_t>(dword >> 8)};
+}
+
+uint32_t Sfdp::getEraseTime_ms(const uint8_t index) const {
+    if (index >= 4 || bfptDwords < 10) return 0;
+    const uint32_t dword = getDword(10);
+    // Typical time as count and unit (1, 16, 128 or 1000 ms), the maximum is 2 * (multiplier + 1) times that
+    const uint32_t time = dword >> (4 + index * 7) & 0x7F;
+    constexpr uint16_t units[4] = {1, 16, 128, 1000};
+    const uint32_t typical = ((time & 0x1F) + 1) * units[time >> 5];
+    return 2 * ((dword & 0x0F) + 1) * typical;
+}
+
+uint32_t Sfdp::getChipEraseTime_ms() const {
+    if (bfptDwords < 11) return 0;
+    const uint32_t time = getDword(11) >> 24 & 0x7F;
+    constexpr uint32_t units[4] = {16, 256, 4000, 64000};
+    const uint32_t typical = ((time & 0x1F) + 1) * units[time >> 5];
+    return 2 * ((getDword(10) & 0x0F) + 1) * typical;
+}
+
+uint8_t Sfdp::get4KEraseOpcode() const {
+    return (getDword(1) & 0x03) == 0x01 ? static_cast<uint8_t>(getDword(1) >> 8) : 0;
+}
+
+Sfdp::FastRead Sfdp::getFastRead(const FastReadMode mode) const {
+    uint8_t supportBit;
+    uint32_t parameters;
+    FastRead fastRead = {};
+    switch (mode) {
+        case FastReadMode::FAST_READ_1_1_2:
+            supportBit = 16;
+            parameters = getDword(4);
+            fastRead.addressLanes = 1;
+            fastRead.dataLanes = 2;
+            break;
+        case FastReadMode::FAST_READ_1_2_2:
+            supportBit = 20;
+            parameters = getDword(4) >> 16;
+            fastRead.addressLanes = 2;
+            fastRead.dataLanes = 2;
+            break;
+        case FastReadMode::FAST_READ_1_1_4:
+            supportBit = 22;
+            parameters = getDword(3) >> 16;
+            fastRead.addressLanes = 1;
+            fastRead.dataLanes = 4;
+            break;
+        default:
+            supportBit = 21;
+            parameters = getDword(3);
+            fastRead.addressLanes = 4;
+            fastRead.dataLanes = 4;
+            break;
+    }
+    if (bfptDwords < 4 || (getDword(1) & 1UL << supportBit) == 0) return {};
+    fastRead.waitStates = parameters & 0x1F;
+    fastRead.modeClocks = parameters >> 5 & 0x07;
+    fastRead.opcode = parameters >> 8 & 0xFF;
+    return fastRead;
+}
+
+bool Sfdp::hasParameterTable(const uint16_t id) const {
+    for (uint8_t i = 0; i < parameterCount; i++) {
+        if (parameterIds[i] == id) return true;
+    }
+    return false;
+}
+
+HalStatus Sfdp::load(const Reader reader, void *context) {
+    bfptDwords = 0;
+    parameterCount = 0;
+
+    uint8_t header[8 + 8 * MAX_PARAMETER_HEADERS];
+    auto ret = reader(context, 0, header, 8);
+    if (ret != HalStatus::HAL_OK) return ret;
+    const uint32_t signature = header[0] | header[1] << 8 | header[2] << 16 | static_cast<uint32_t>(header[3]) << 24;
+    if (signature != SIGNATURE) return HalStatus::HAL_ERROR;
+
+    const uint8_t parameterHeaders = std::min(static_cast<uint8_t>(header[6] + 1), MAX_PARAMETER_HEADERS);
+    ret = reader(context, 8, &header[8], parameterHeaders * 8);
+    if (ret != HalStatus::HAL_OK) return ret;
+
+    // Use the BFPT with the highest revision
+    const uint8_t *bfptHeader = nullptr;
+    for (uint8_t i = 0; i < parameterHeaders; i++) {
+        const uint8_t *parameterHeader = &header[8 + i * 8];
+        parameterIds[parameterCount++] = parameterHeader[7] << 8 | parameterHeader[0];
+        if ((parameterHeader[7] << 8 | parameterHeader[0]) != BFPT_ID) continue;
+        if (bfptHeader == nullptr || (parameterHeader[2] << 8 | parameterHeader[1]) >= (bfptHeader[2] << 8 |
+                                                                                        bfptHeader[1])) {
+            bfptHeader = parameterHeader;
+        }
+    }
+    if (bfptHeader == nullptr || bfptHeader[3] < 2) return HalStatus::HAL_ERROR;
+
+    const uint32_t pointer = bfptHeader[4] | bfptHeader[5] << 8 | bfptHeader[6] << 16;
+    const uint8_t dwords = std::min(bfptHeader[3], BFPT_MAX_DWORDS);
+    uint8_t table[BFPT_MAX_DWORDS * 4];
+    ret = reader(context, pointer, table, dwords * 4);
+    if (ret != HalStatus::HAL_OK) return ret;
+    for (uint8_t i = 0; i < dwords; i++) {
+        bfpt[i] = table[i * 4] | table[i * 4 + 1] << 8 | table[i * 4 + 2] << 16 |
+                  static_cast<uint32_t>(table[i * 4 + 3]) << 24;
+    }
+    bfptDwords = dwords;
+    return HalStatus::HAL_OK;
+}
+
+HalStatus Sfdp::readDevice(void *context, const uint32_t addr, uint8_t *data, const uint16_t size) {
+    const auto spi = static_cast<AbstractSpiTransport *>(context);
+    spi->select();
+    // Instruction, 24 bit address and 8 dummy clocks
+    auto ret = spi->transmit(INSTRUCTION);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->receive(data, size);
+    spi->unselect();
+    return ret;
+}
+
+HalStatus Sfdp::readImage(void *context, const uint32_t addr, uint8_t *data, const uint16_t size) {
+    const auto image = static_cast<const Image *>(context);
+    if (addr > image->size || size > image->size - addr) return HalStatus::HAL_ERROR;
+    std::memcpy(data, &image->data[addr], size);
+    return HalStatus::HAL_OK;
+}
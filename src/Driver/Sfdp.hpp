@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_SFDP_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_SFDP_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "Transport/AbstractSpiTransport.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Serial Flash Discoverable Parameters (JESD216) of a SPI NOR flash.
+     *
+     * read() fetches the SFDP header and the JEDEC Basic Flash Parameter Table (BFPT) from the device, parse()
+     * does the same for a recorded SFDP image. The accessors decode the BFPT and return 0 for parameters the
+     * table does not contain.
+     */
+    class Sfdp {
+    public:
+        static constexpr uint8_t INSTRUCTION = 0x5A;
+        static constexpr uint32_t SIGNATURE = 0x50444653; ///< "SFDP", least significant byte first
+        static constexpr uint16_t BFPT_ID = 0xFF00;
+        static constexpr uint16_t SECTOR_MAP_ID = 0xFF81;
+        static constexpr uint8_t MAX_PARAMETER_HEADERS = 8;
+        static constexpr uint8_t BFPT_MAX_DWORDS = 23; ///< Length of the BFPT in JESD216F
+
+        struct EraseType {
+            uint32_t size; ///< Bytes erased by the instruction, 0 if the erase type is not supported
+            uint8_t opcode;
+        };
+
+        /**
+         * @brief A fast read instruction, named after the lanes of instruction, address and data (1-1-2, ...).
+         */
+        struct FastRead {
+            uint8_t opcode; ///< 0 if the device does not support the instruction
+            uint8_t addressLanes;
+            uint8_t dataLanes;
+            uint8_t modeClocks;
+            uint8_t waitStates; ///< Dummy clocks after the mode clocks
+        };
+
+        enum class FastReadMode : uint8_t {
+            FAST_READ_1_1_2,
+            FAST_READ_1_2_2,
+            FAST_READ_1_1_4,
+            FAST_READ_1_4_4
+        };
+
+        /**
+         * @brief Reads the SFDP header and the BFPT from the device.
+         *
+         * @return HAL_ERROR if the device has no valid SFDP header or BFPT.
+         */
+        Stm32Common::HalStatus read(AbstractSpiTransport *spi);
+
+        /**
+         * @brief Takes the SFDP header and the BFPT from a recorded SFDP image.
+         *
+         * @return false if the image has no valid SFDP header or BFPT.
+         */
+        bool parse(const uint8_t *image, uint32_t size);
+
+        [[nodiscard]] bool isValid() const { return bfptDwords > 0; }
+
+        [[nodiscard]] uint8_t getBfptDwords() const { return bfptDwords; }
+
+        /**
+         * @brief Returns a DWORD of the BFPT, numbered from 1 as in JESD216.
+         */
+        [[nodiscard]] uint32_t getDword(const uint8_t n) const {
+            return n >= 1 && n <= bfptDwords ? bfpt[n - 1] : 0;
+        }
+
+        /**
+         * @brief Returns the size of the array in bytes.
+         */
+        [[nodiscard]] uint32_t getDensity() const;
+
+        /**
+         * @brief Returns the page size in bytes, 256 if the BFPT is too old to contain it.
+         */
+        [[nodiscard]] uint32_t getPageSize() const;
+
+        /**
+         * @brief Returns one of the four erase types of the BFPT.
+         *
+         * @param index 0 to 3.
+         */
+        [[nodiscard]] EraseType getEraseType(uint8_t index) const;
+
+        /**
+         * @brief Returns the maximum time of an erase type in ms, 0 if the BFPT does not contain it.
+         */
+        [[nodiscard]] uint32_t getEraseTime_ms(uint8_t index) const;
+
+        /**
+         * @brief Returns the maximum chip erase time in ms, 0 if the BFPT does not contain it.
+         */
+        [[nodiscard]] uint32_t getChipEraseTime_ms() const;
+
+        /**
+         * @brief Returns the opcode of the 4 KByte erase from DWORD 1, 0 if the device has none.
+         */
+        [[nodiscard]] uint8_t get4KEraseOpcode() const;
+
+        /**
+         * @brief Returns a fast read instruction, opcode 0 if the device does not support it.
+         */
+        [[nodiscard]] FastRead getFastRead(FastReadMode mode) const;
+
+        /**
+         * @brief Returns the Quad Enable Requirements (QER) of DWORD 15, 0 if the device has no QE bit.
+         */
+        [[nodiscard]] uint8_t getQuadEnableRequirements() const { return getDword(15) >> 20 & 0x07; }
+
+        /**
+         * @brief Returns true if the device is polled with the flag status register (0x70) instead of RDSR.
+         */
+        [[nodiscard]] bool isFlagStatusPolling() const {
+            return (getDword(14) & 1 << 2) == 0 && (getDword(14) & 1 << 3) > 0;
+        }
+
+        /**
+         * @brief Returns true if the device only accepts 3 byte addresses.
+         */
+        [[nodiscard]] bool is3ByteAddressing() const { return (getDword(1) >> 17 & 0x03) != 2; }
+
+        /**
+         * @brief Returns true if the SFDP header lists a parameter table with the given ID, e.g. SECTOR_MAP_ID.
+         */
+        [[nodiscard]] bool hasParameterTable(uint16_t id) const;
+
+    protected:
+        using Reader = Stm32Common::HalStatus (*)(void *context, uint32_t addr, uint8_t *data, uint16_t size);
+
+        struct Image {
+            const uint8_t *data;
+            uint32_t size;
+        };
+
+        Stm32Common::HalStatus load(Reader reader, void *context);
+
+        static Stm32Common::HalStatus readDevice(void *context, uint32_t addr, uint8_t *data, uint16_t size);
+
+        static Stm32Common::HalStatus readImage(void *context, uint32_t addr, uint8_t *data, uint16_t size);
+
+        uint32_t bfpt[BFPT_MAX_DWORDS] = {};
+        uint8_t bfptDwords = 0;
+        uint16_t parameterIds[MAX_PARAMETER_HEADERS] = {};
+        uint8_t parameterCount = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include "SimulatedNorDriver.hpp"
+
+using namespace Stm32LevelX::Driver;
+
+ULONG SimulatedNorDriver::getTotalSectors() {
+    return memorySize / SECTOR_SIZE;
+}
+
+ULONG SimulatedNorDriver::getSectorSize() {
+    return SECTOR_SIZE;
+}
+
+UINT SimulatedNorDriver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    if (!isInRange(addr, size)) return LX_ERROR;
+    waitReady();
+
+    // READ + 24 bit address, then the data
+    transaction(4 + size);
+    std::memcpy(out, &memory[addr], size);
+    counters.reads++;
+    counters.bytesRead += size;
+    return LX_SUCCESS;
+}
+
+UINT SimulatedNorDriver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    if (!isInRange(addr, size)) return LX_ERROR;
+
+    uint32_t done = 0;
+    while (done < size) {
+        // A page program must not cross a page boundary
+        const uint32_t pageAddr = addr + done;
+        const uint32_t sz = std::min(static_cast<uint32_t>(size - done), PAGE_SIZE - (pageAddr % PAGE_SIZE));
+        waitReady();
+
+        // WREN, then PP + 24 bit address + data
+        transaction(1);
+        transaction(4 + sz);
+        for (uint32_t i = 0; i < sz; i++) {
+            const uint8_t cell = memory[pageAddr + i];
+            if ((~cell & in[done + i]) != 0) counters.programConflicts++;
+            memory[pageAddr + i] = cell & in[done + i];
+        }
+        busyUntil_ns = clock->now() + timing.tPP_ns;
+        counters.pagePrograms++;
+        counters.bytesWritten += sz;
+        done += sz;
+    }
+    waitReady();
+
+    return LX_SUCCESS;
+}
+
+UINT SimulatedNorDriver::eraseSector(const uint32_t addr, ULONG erase_count) {
+    if (addr % SECTOR_SIZE > 0) return LX_ERROR;
+    if (!isInRange(addr, SECTOR_SIZE)) return LX_ERROR;
+    waitReady();
+
+    // WREN, then SE + 24 bit address
+    transaction(1);
+    transaction(4);
+    std::memset(&memory[addr], 0xFF, SECTOR_SIZE);
+    busyUntil_ns = clock->now() + timing.tSE_ns;
+    counters.sectorErases++;
+    return LX_SUCCESS;
+}
+
+UINT SimulatedNorDriver::verifySectorErased(const uint32_t addr) {
+    if (addr % SECTOR_SIZE > 0) return LX_ERROR;
+    if (!isInRange(addr, SECTOR_SIZE)) return LX_ERROR;
+    waitReady();
+
+    transaction(4 + SECTOR_SIZE);
+    counters.reads++;
+    counters.bytesRead += SECTOR_SIZE;
+    for (uint32_t i = 0; i < SECTOR_SIZE; i++) {
+        if (memory[addr + i] != 0xFF) return LX_ERROR;
+    }
+    return LX_SUCCESS;
+}
+
+UINT SimulatedNorDriver::initialize() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::SimulatedNorDriver::initialize()\r\n");
+
+    reset();
+    return LX_SUCCESS;
+}
+
+UINT SimulatedNorDriver::reset() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::SimulatedNorDriver::reset()\r\n");
+
+    // RSTEN, RST. A reset does not abort a running erase in this model.
+    waitReady();
+    transaction(1);
+    transaction(1);
+    return LX_SUCCESS;
+}
+
+void SimulatedNorDriver::transaction(const uint32_t bytes) {
+    counters.transactions++;
+    clock->advance(timing.csOverhead_ns + static_cast<uint64_t>(bytes) * 8 * 1000000000ULL / timing.spiClockHz);
+}
+
+void SimulatedNorDriver::waitReady() {
+    if (busyUntil_ns > clock->now()) {
+        counters.busyWait_ns += busyUntil_ns - clock->now();
+        clock->advanceTo(busyUntil_ns);
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_SIMULATEDNORDRIVER_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_SIMULATEDNORDRIVER_HPP
+
+#include <cstring>
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "../AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Virtual time base for simulated flash devices.
+     *
+     * Simulated devices do not sleep, they charge the time an operation would take on real hardware to a
+     * virtual clock. Several devices may share one clock to model operations that overlap in time.
+     */
+    class VirtualClock {
+    public:
+        [[nodiscard]] uint64_t now() const { return now_ns; }
+
+        void advance(const uint64_t ns) { now_ns += ns; }
+
+        void advanceTo(const uint64_t ns) { if (ns > now_ns) now_ns = ns; }
+
+        void reset() { now_ns = 0; }
+
+    private:
+        uint64_t now_ns = 0;
+    };
+
+
+    /**
+     * @brief RAM backed NOR flash device, modelled after the SST26VF016B.
+     *
+     * The device uses 4 KB sectors and 256 byte pages. Programming can only clear bits (1 -> 0) and an
+     * erase sets a whole sector back to 0xFF. Every operation charges the time it would take on the real
+     * device (SPI transfer, tPP, tSE) to a VirtualClock, so throughput, mount time and garbage collection
+     * cost can be measured without hardware.
+     *
+     * eraseSector() returns as soon as the erase command is issued. The device stays busy until tSE has elapsed
+     * and the next access waits for it. Sst26Driver::eraseSector() waits for the erase itself, because LevelX
+     * writes the erase count right after it, so both charge the same time to the clock.
+     */
+    class SimulatedNorDriver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
+    public:
+        static constexpr uint32_t PAGE_SIZE = 256;
+        static constexpr uint32_t SECTOR_SIZE = 4096;
+
+        /**
+         * @brief Timing parameters of the simulated device.
+         *
+         * The defaults are the maximum values from the SST26VF016B datasheet.
+         */
+        struct Timing {
+            uint32_t spiClockHz = 40000000; ///< SPI clock frequency
+            uint32_t csOverhead_ns = 50; ///< Chip select setup and hold time per transaction
+            uint32_t tPP_ns = 1500000; ///< Page program time
+            uint32_t tSE_ns = 25000000; ///< Sector erase time
+            uint32_t tBE_ns = 25000000; ///< Block erase time
+            uint32_t tCE_ns = 50000000; ///< Chip erase time
+            uint32_t tWS_ns = 10000; ///< Time from WRSU until the erase is suspended
+        };
+
+        /**
+         * @brief Operation counters of the simulated device.
+         */
+        struct Counters {
+            uint32_t transactions; ///< Chip select toggles
+            uint32_t reads; ///< Read commands
+            uint32_t pagePrograms; ///< Page program commands
+            uint32_t sectorErases; ///< Sector erase commands
+            uint32_t programConflicts; ///< Bits that should have been programmed from 0 to 1
+            uint64_t bytesRead; ///< Payload bytes read
+            uint64_t bytesWritten; ///< Payload bytes programmed
+            uint64_t busyWait_ns; ///< Time spent waiting for a program or erase to finish
+        };
+
+
+        /**
+         * @param memory Memory that holds the simulated flash array. Its size must be a multiple of SECTOR_SIZE.
+         * @param size Size of the memory in bytes.
+         * @param clock Clock to charge the operation times to. Shared between devices to model parallel chips.
+         */
+        SimulatedNorDriver(uint8_t *memory, const uint32_t size, VirtualClock *clock)
+            : memory(memory), memorySize(size), clock(clock) { ; }
+
+        SimulatedNorDriver(uint8_t *memory, const uint32_t size, VirtualClock *clock,
+                           Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              memory(memory), memorySize(size), clock(clock) { ; }
+
+
+        void setTiming(const Timing &newTiming) { timing = newTiming; }
+        [[nodiscard]] const Timing &getTiming() const { return timing; }
+
+        [[nodiscard]] const Counters &getCounters() const { return counters; }
+        void resetCounters() { counters = {}; }
+
+        [[nodiscard]] VirtualClock *getClock() const { return clock; }
+        [[nodiscard]] uint8_t *getMemory() const { return memory; }
+        [[nodiscard]] bool isBusy() const { return busyUntil_ns > clock->now(); }
+
+        /**
+         * @brief Sets the whole array to 0xFF without charging any time.
+         */
+        void format() {
+            std::memset(memory, 0xFF, memorySize);
+            busyUntil_ns = 0;
+        }
+
+
+        ULONG getTotalSectors() override;
+
+        ULONG getSectorSize() override;
+
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
+
+        UINT eraseSector(uint32_t addr, ULONG erase_count) override;
+
+        UINT verifySectorErased(uint32_t addr) override;
+
+        UINT initialize() override;
+
+        UINT reset() override;
+
+    protected:
+        /**
+         * @brief Charges one chip select framed SPI transaction of the given length to the clock.
+         */
+        void transaction(uint32_t bytes);
+
+        /**
+         * @brief Waits until a running program or erase operation has finished.
+         */
+        void waitReady();
+
+        [[nodiscard]] bool isInRange(const uint32_t addr, const uint32_t len) const {
+            return addr <= memorySize && len <= memorySize - addr;
+        }
+
+        uint8_t *memory;
+        uint32_t memorySize;
+        VirtualClock *clock;
+        Timing timing = {};
+        Counters counters = {};
+        uint64_t busyUntil_ns = 0;
+    };
+}
+
+#endif
@@ -3,116 +3,550 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "Sst26Driver.hpp"
 
 using namespace Stm32LevelX::Driver;
 
 ULONG Sst26Driver::getTotalSectors() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::getTotalBlocks()\r\n");
 
-    return 512;
+    return totalSize / SECTOR_SIZE;
 }
 
 ULONG Sst26Driver::getSectorSize() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::getSectorSize()\r\n");
 
     return SECTOR_SIZE;
 }
 
-UINT Sst26Driver::read(const uint32_t addr, uint8_t *out, const uint16_t size) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+UINT Sst26Driver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::read(0x%08x, %p, %lu)\r\n",
                      addr, &out, size);
-    const auto ret = READ(addr, out, size);
+    const bool suspended = beginAccess(addr, size);
+    const auto ret = readMemory(ReadMode::AUTO, addr, out, size);
+    endAccess(suspended);
+    return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+UINT Sst26Driver::readv(const Segment *segments, const size_t count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Sst26Driver::readv(%p, %lu)\r\n",
+                     segments, count);
+    if (count == 0) return LX_SUCCESS;
+
+    uint32_t low = segments[0].addr;
+    uint32_t high = segments[0].addr;
+    for (size_t i = 0; i < count; i++) {
+        low = std::min(low, segments[i].addr);
+        high = std::max(high, static_cast<uint32_t>(segments[i].addr + segments[i].size));
+    }
+
+    const auto mode = getEffectiveReadMode();
+    const bool suspended = beginAccess(low, high - low);
+    HalStatus ret = HalStatus::HAL_OK;
+    bool selected = false;
+    uint32_t position = 0;
+    for (size_t i = 0; i < count && ret == HalStatus::HAL_OK; i++) {
+        const Segment &segment = segments[i];
+        if (selected && (segment.addr < position || segment.addr - position > READV_MAX_GAP)) {
+            spi->unselect();
+            selected = false;
+        }
+        if (selected) {
+            // Cheaper than the instruction, address and dummy bytes of a new command
+            uint8_t gap[READV_MAX_GAP];
+            if (segment.addr > position) ret = spi->receive(gap, segment.addr - position);
+        } else {
+            spi->select();
+            selected = true;
+            ret = transmitReadHeader(mode, segment.addr);
+        }
+        ret = ret != HalStatus::HAL_OK ? ret : receiveLong(segment.data, segment.size);
+        position = segment.addr + segment.size;
+    }
+    if (selected) spi->unselect();
+    endAccess(suspended);
     return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
 }
 
-UINT Sst26Driver::write(const uint32_t addr, uint8_t *in, const uint16_t size) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+HalStatus Sst26Driver::readMemory(ReadMode mode, const uint32_t addr, uint8_t *pData, const size_t size) {
+    if (mode == ReadMode::AUTO) mode = getEffectiveReadMode();
+    spi->select();
+    auto ret = transmitReadHeader(mode, addr);
+    ret = ret != HalStatus::HAL_OK ? ret : receiveLong(pData, size);
+    spi->unselect();
+    return ret;
+}
+
+HalStatus Sst26Driver::receiveLong(uint8_t *pData, const size_t size) {
+    HalStatus ret = HalStatus::HAL_OK;
+    for (size_t offset = 0; offset < size && ret == HalStatus::HAL_OK;) {
+        const auto sz = static_cast<uint16_t>(std::min(size - offset, static_cast<size_t>(MAX_TRANSFER_SIZE)));
+        ret = receiveData(&pData[offset], sz);
+        offset += sz;
+    }
+    return ret;
+}
+
+Sst26Driver::ReadMode Sst26Driver::getEffectiveReadMode() const {
+    if (readMode != ReadMode::AUTO) return readMode;
+    if (spi->getMaxLanes() >= 4) return ReadMode::SQIOR;
+    if (spi->getMaxLanes() >= 2) return ReadMode::SDIOR;
+    const uint32_t clock = spi->getClockHz();
+    return clock > 0 && clock <= READ_MAX_CLOCK_HZ ? ReadMode::READ : ReadMode::READ_HS;
+}
+
+const char *Sst26Driver::getReadModeName(const ReadMode mode) {
+    switch (mode) {
+        case ReadMode::AUTO:
+            return "AUTO";
+        case ReadMode::READ:
+            return "READ";
+        case ReadMode::READ_HS:
+            return "READ_HS";
+        case ReadMode::SDOR:
+            return "SDOR";
+        case ReadMode::SDIOR:
+            return "SDIOR";
+        case ReadMode::SQOR:
+            return "SQOR";
+        case ReadMode::SQIOR:
+            return "SQIOR";
+    }
+    return "?";
+}
+
+HalStatus Sst26Driver::transmitReadHeader(const ReadMode mode, const uint32_t addr) {
+    HalStatus ret;
+    switch (mode) {
+        case ReadMode::READ:
+            return spi->transmit_be((Instruction::READ << 24) | (addr & 0x00FFFFFF));
+        case ReadMode::SDOR:
+            ret = spi->transmit(Instruction::SDOR);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+            return ret != HalStatus::HAL_OK ? ret : spi->setLanes(2);
+        case ReadMode::SDIOR:
+            ret = spi->transmit(Instruction::SDIOR);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->setLanes(2);
+            return ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+        case ReadMode::SQOR:
+            ret = spi->transmit(Instruction::SQOR);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+            return ret != HalStatus::HAL_OK ? ret : spi->setLanes(4);
+        case ReadMode::SQIOR:
+            ret = spi->transmit(Instruction::SQIOR);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->setLanes(4);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+            return ret != HalStatus::HAL_OK ? ret : spi->transmit_be(static_cast<uint16_t>(0xFFFF));
+        default:
+            ret = spi->transmit(Instruction::READ_HS);
+            return ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
+    }
+}
+
+UINT Sst26Driver::readAsync(const uint32_t addr, uint8_t *out, const size_t size,
+                            const ReadCallback callback, void *context) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Sst26Driver::readAsync(0x%08x, %p, %lu)\r\n",
+                     addr, &out, size);
+    // One DMA transfer cannot take more
+    if (size > MAX_TRANSFER_SIZE) return AbstractNorDriver::readAsync(addr, out, size, callback, context);
+
+    // On success, receiveAsync() hands the lock over to the transfer, which releases it after the callback
+    spi->lock();
+    if (readAsyncCallback != nullptr || pendingErase != 0 || pendingWriteData != nullptr) {
+        spi->unlock();
+        return LX_ERROR;
+    }
+    readAsyncContext = context;
+    readAsyncCallback = callback;
+
+    spi->select();
+    auto ret = transmitReadHeader(getEffectiveReadMode(), addr);
+    ret = ret != HalStatus::HAL_OK ? ret : spi->receiveAsync(out, size, onReadAsyncComplete, this);
+    if (ret != HalStatus::HAL_OK) {
+        spi->unselect();
+        readAsyncCallback = nullptr;
+        spi->unlock();
+        return LX_ERROR;
+    }
+    return LX_SUCCESS;
+}
+
+void Sst26Driver::onReadAsyncComplete(const HalStatus status, void *context) {
+    const auto self = static_cast<Sst26Driver *>(context);
+    self->spi->unselect();
+    const ReadCallback callback = self->readAsyncCallback;
+    self->readAsyncCallback = nullptr;
+    callback(status == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR, self->readAsyncContext);
+}
+
+UINT Sst26Driver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::write(0x%08x, %p, %lu)\r\n",
                      addr, &in, size);
 
-    const uint16_t SLICES = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    beginAccess(addr, 0);
+    const UINT ret = writePages(addr, in, size);
+    endAccess(false);
+    return ret;
+}
 
-    for (uint16_t i = 0; i < SLICES; i++) {
-        const uint16_t sz = std::min(size - i * PAGE_SIZE, PAGE_SIZE);
-        HalStatus ret = WREN();
-        if (ret != HalStatus::HAL_OK) return LX_ERROR;
-        ret = PP(addr + i * PAGE_SIZE, &in[i * PAGE_SIZE], sz);
+UINT Sst26Driver::writePages(const uint32_t addr, uint8_t *in, const size_t size) {
+    for (size_t offset = 0; offset < size;) {
+        // A page program must not cross a page boundary
+        const uint32_t pageAddr = addr + offset;
+        const auto sz = static_cast<uint16_t>(std::min(size - offset,
+                                                       static_cast<size_t>(PAGE_SIZE - (pageAddr & (PAGE_SIZE - 1)))));
+        HalStatus ret = programPage(pageAddr, &in[offset], sz);
         if (ret != HalStatus::HAL_OK) return LX_ERROR;
         ret = waitForWriteFinish(10);
         if (ret != HalStatus::HAL_OK) return LX_ERROR;
+        const UINT verified = verifyPage(pageAddr, &in[offset], sz);
+        if (verified != LX_SUCCESS) return verified;
+        offset += sz;
+    }
+    if (programPipeline) {
+        // WEL has been cleared by the last page program, WRDI and its status check are not needed
+        savedTransactions += 2;
+    } else {
+        WRDI();
     }
-    WRDI();
 
-    // Check written bytes
-#ifndef LIBSMART_STM32LEVELX_PP_READ_BACK_TEST
-    constexpr uint16_t BUFFER_SIZE = 32;
-    uint8_t buffer[BUFFER_SIZE] = {};
-    const uint16_t SLICES_CHK = (size + BUFFER_SIZE - 1) / BUFFER_SIZE;
+    return LX_SUCCESS;
+}
 
-    for (uint16_t iSlice = 0; iSlice < SLICES_CHK; iSlice++) {
-        const uint16_t sz = std::min(static_cast<uint16_t>(size - iSlice * BUFFER_SIZE), BUFFER_SIZE);
-        const HalStatus ret = READ(addr + iSlice * BUFFER_SIZE, buffer, sz);
-        if (ret != HalStatus::HAL_OK) return LX_ERROR;
-        if (std::memcmp(buffer, &in[iSlice * BUFFER_SIZE], sz) != 0) return LX_INVALID_WRITE;
+HalStatus Sst26Driver::transmitProgram(const ProgramMode mode, const uint32_t addr, uint8_t *in,
+                                       const uint16_t size) {
+    const auto sz = std::min(size, static_cast<uint16_t>(PAGE_SIZE - (addr & 0x000000FF)));
+    HalStatus ret;
+    spi->select();
+    if (mode == ProgramMode::SQPP) {
+        const uint8_t address[3] = {
+            static_cast<uint8_t>(addr >> 16), static_cast<uint8_t>(addr >> 8), static_cast<uint8_t>(addr)
+        };
+        ret = spi->transmit(Instruction::SQPP);
+        ret = ret != HalStatus::HAL_OK ? ret : spi->setLanes(4);
+        ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(address, sizeof(address));
+    } else {
+        ret = spi->transmit_be(Instruction::PP << 24 | (addr & 0x00FFFFFF));
     }
-#endif
+    ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(in, sz);
+    spi->unselect();
+    return ret;
+}
 
-    return LX_SUCCESS;
+HalStatus Sst26Driver::programPage(const uint32_t addr, uint8_t *in, const uint16_t size) {
+    const auto mode = getEffectiveProgramMode();
+    if (!programPipeline) {
+        const auto ret = WREN();
+        if (ret != HalStatus::HAL_OK) return ret;
+        return mode == ProgramMode::SQPP ? SQPP(addr, in, size) : PP(addr, in, size);
+    }
+
+    // A lost WREN makes the device ignore the program. verifyPage() detects that, without it WEL is read once.
+    const bool checkWel = verifyPolicy == VerifyPolicy::OFF;
+    auto ret = transmitInstruction(Instruction::WREN);
+    if (ret == HalStatus::HAL_OK && checkWel) {
+        uint8_t status = 0;
+        ret = RDSR(status);
+        if (ret == HalStatus::HAL_OK && (status & 1 << 1) == 0) ret = HalStatus::HAL_ERROR;
+    }
+    ret = ret != HalStatus::HAL_OK ? ret : transmitProgram(mode, addr, in, size);
+    if (ret != HalStatus::HAL_OK) return ret;
+    // WEL read back after WREN and WEL check before the page program
+    savedTransactions += checkWel ? 1 : 2;
+    return ret;
+}
+
+UINT Sst26Driver::verifyPage(const uint32_t addr, const uint8_t *in, const uint16_t size) {
+    if (verifyPolicy == VerifyPolicy::OFF) return LX_SUCCESS;
+
+    Crc32 crc;
+    uint32_t expectedCrc = 0;
+    if (verifyPolicy == VerifyPolicy::CRC32) {
+        crc.update(in, size);
+        expectedCrc = crc.get();
+        crc.reset();
+    }
+
+    uint8_t buffer[VERIFY_CHUNK_SIZE];
+    bool equal = true;
+    spi->select();
+    auto ret = transmitReadHeader(getEffectiveReadMode(), addr);
+    for (uint16_t offset = 0; offset < size && equal && ret == HalStatus::HAL_OK; offset += VERIFY_CHUNK_SIZE) {
+        const auto sz = std::min(static_cast<uint16_t>(size - offset), VERIFY_CHUNK_SIZE);
+        ret = receiveData(buffer, sz);
+        if (ret != HalStatus::HAL_OK) break;
+        if (verifyPolicy == VerifyPolicy::CRC32) {
+            crc.update(buffer, sz);
+        } else {
+            equal = std::memcmp(buffer, &in[offset], sz) == 0;
+        }
+    }
+    spi->unselect();
+
+    if (ret != HalStatus::HAL_OK) return LX_ERROR;
+    if (verifyPolicy == VerifyPolicy::CRC32) equal = crc.get() == expectedCrc;
+    return equal ? LX_SUCCESS : LX_INVALID_WRITE;
 }
 
 UINT Sst26Driver::eraseSector(const uint32_t addr, ULONG erase_count) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::eraseSector(0x%08x)\r\n",
                      addr);
 
     if (addr % SECTOR_SIZE > 0) return LX_ERROR;
-    WREN();
-    const HalStatus ret = SE(addr);
-    WRDI();
+    // LevelX writes the erase count right after the erase, so the device must be ready again. WEL is
+    // cleared by the device when the erase completes.
+    const auto ret = eraseAndWait(Instruction::SE, addr, 50);
     return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
 }
 
+UINT Sst26Driver::eraseRange(const uint32_t addr, const uint32_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Sst26Driver::eraseRange(0x%08x, %lu)\r\n",
+                     addr, size);
+
+    if (addr % SECTOR_SIZE > 0 || size % SECTOR_SIZE > 0 || addr > totalSize || size > totalSize - addr) {
+        return LX_ERROR;
+    }
+
+    if (addr == 0 && size == totalSize) {
+        const auto ret = eraseAndWait(Instruction::CE, 0, 100);
+        return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+    }
+
+    uint32_t offset = addr;
+    while (offset < addr + size) {
+        const uint32_t blockSize = getEraseBlockSize(offset);
+        const bool block = offset % blockSize == 0 && addr + size - offset >= blockSize;
+        const auto ret = eraseAndWait(block ? Instruction::BE : Instruction::SE, offset, 50);
+        if (ret != HalStatus::HAL_OK) return LX_ERROR;
+        offset += block ? blockSize : SECTOR_SIZE;
+    }
+    return LX_SUCCESS;
+}
+
+UINT Sst26Driver::startWrite(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Sst26Driver::startWrite(0x%08x, %p, %lu)\r\n",
+                     addr, &in, size);
+
+    if (size == 0) return LX_SUCCESS;
+    const uint32_t lastPage = std::max(addr, static_cast<uint32_t>(addr + size - 1) & ~(PAGE_SIZE - 1));
+    const size_t head = lastPage - addr;
+
+    beginAccess(addr, 0);
+    UINT ret = head > 0 ? writePages(addr, in, head) : LX_SUCCESS;
+    const auto tail = static_cast<uint16_t>(size - head);
+    if (ret == LX_SUCCESS && programPage(lastPage, &in[head], tail) != HalStatus::HAL_OK) ret = LX_ERROR;
+    if (ret == LX_SUCCESS) {
+        pendingWriteAddr = lastPage;
+        pendingWriteData = &in[head];
+        pendingWriteSize = tail;
+    }
+    endAccess(false);
+    return ret;
+}
+
+UINT Sst26Driver::startEraseSector(const uint32_t addr, ULONG erase_count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Sst26Driver::startEraseSector(0x%08x)\r\n",
+                     addr);
+
+    if (addr % SECTOR_SIZE > 0) return LX_ERROR;
+    return startErase(Instruction::SE, addr) == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+UINT Sst26Driver::finish() {
+    UINT ret = LX_SUCCESS;
+    if (pendingErase != 0 && waitForErase(50) != HalStatus::HAL_OK) ret = LX_ERROR;
+
+    if (pendingWriteData != nullptr) {
+        beginAccess(pendingWriteAddr, 0);
+        if (waitForWriteFinish(10) != HalStatus::HAL_OK) {
+            ret = LX_ERROR;
+        } else {
+            const UINT verified = verifyPage(pendingWriteAddr, pendingWriteData, pendingWriteSize);
+            if (verified != LX_SUCCESS) ret = verified;
+        }
+        if (programPipeline) {
+            savedTransactions += 2;
+        } else {
+            WRDI();
+        }
+        pendingWriteData = nullptr;
+        endAccess(false);
+    }
+    return ret;
+}
+
+HalStatus Sst26Driver::startErase(const uint8_t instruction, const uint32_t addr) {
+    beginAccess(addr, 0);
+    WREN();
+    const HalStatus ret = instruction == Instruction::CE
+                              ? CE()
+                              : instruction == Instruction::BE
+                                    ? BE(addr)
+                                    : SE(addr);
+    if (ret == HalStatus::HAL_OK) {
+        pendingEraseAddr = addr;
+        pendingEraseSize = instruction == Instruction::BE ? getEraseBlockSize(addr) : SECTOR_SIZE;
+        pendingEraseSuspensions = 0;
+        pendingErase = instruction;
+    }
+    endAccess(false);
+    return ret;
+}
+
+HalStatus Sst26Driver::waitForErase(const uint32_t timeout_ms) {
+    // Poll without holding the lock, so reads of other threads get the device in between
+    HalStatus ret = HalStatus::HAL_OK;
+    uint32_t start_ms = millis();
+    uint32_t suspensions = eraseSuspensions;
+    while (true) {
+        uint8_t status = 0;
+        spi->lock();
+        ret = RDSR(status);
+        // BUSY or WSE, the erase is still running or suspended
+        const bool done = ret != HalStatus::HAL_OK || (status & (1 << 0 | 1 << 2)) == 0;
+        // Cleared inside the lock, so beginAccess() never sees a finished erase as pending
+        if (done) pendingErase = 0;
+        spi->unlock();
+        if (done) break;
+        // Time the erase has been suspended does not count. beginAccess() suspends an erase at most
+        // MAX_SUSPENSIONS_PER_ERASE times, so the timeout is extended a bounded number of times.
+        if (suspensions != eraseSuspensions) {
+            suspensions = eraseSuspensions;
+            start_ms = millis();
+        }
+        delay(1);
+        if ((timeout_ms > 0) && (millis() - start_ms > timeout_ms)) {
+            spi->lock();
+            pendingErase = 0;
+            spi->unlock();
+            return HalStatus::HAL_TIMEOUT;
+        }
+    }
+    return ret;
+}
+
+bool Sst26Driver::beginAccess(const uint32_t addr, const uint32_t size) {
+    spi->lock();
+    // The page program startWrite() left running, the device does not accept reads until it has finished
+    if (pendingWriteData != nullptr) waitForWriteFinish(10);
+    const uint8_t erase = pendingErase;
+    if (erase == 0) return false;
+    // The block that is being erased cannot be read while the erase is suspended
+    const bool overlaps = addr < pendingEraseAddr + pendingEraseSize && pendingEraseAddr < addr + size;
+    if (size > 0 && eraseSuspend && erase != Instruction::CE && !overlaps &&
+        pendingEraseSuspensions < MAX_SUSPENSIONS_PER_ERASE && suspendErase()) {
+        pendingEraseSuspensions++;
+        return true;
+    }
+    waitForWriteFinish(100);
+    return false;
+}
+
+void Sst26Driver::endAccess(const bool suspended) {
+    if (suspended) WRRE();
+    spi->unlock();
+}
+
+bool Sst26Driver::suspendErase() {
+    if (WRSU() != HalStatus::HAL_OK) return false;
+    uint8_t status = 0;
+    for (uint16_t i = 0; i < SUSPEND_POLL_LIMIT; i++) {
+        if (RDSR(status) != HalStatus::HAL_OK) return false;
+        if ((status & 1 << 0) == 0) break;
+    }
+    // WSE is not set if the erase finished before WRSU
+    if ((status & (1 << 0 | 1 << 2)) != 1 << 2) return false;
+    eraseSuspensions = eraseSuspensions + 1;
+    return true;
+}
+
+uint32_t Sst26Driver::getEraseBlockSize(const uint32_t addr) {
+    if (addr < 0x8000 || addr >= totalSize - 0x8000) return 0x2000;
+    if (addr < 0x10000 || addr >= totalSize - 0x10000) return 0x8000;
+    return 0x10000;
+}
+
 UINT Sst26Driver::verifySectorErased(const uint32_t addr) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::verifySectorErased(0x%08x)\r\n",
                      addr);
 
     if (addr % SECTOR_SIZE > 0) return LX_ERROR;
-    constexpr uint16_t BUFFER_SIZE = 32;
-    constexpr uint16_t SLICES = (SECTOR_SIZE + BUFFER_SIZE - 1) / BUFFER_SIZE;
-    uint8_t buffer[BUFFER_SIZE];
-    std::memset(buffer, 0xFF, BUFFER_SIZE);
-
-    for (uint16_t idx = 0; idx < SLICES; idx++) {
-        const uint16_t sz = std::min(SECTOR_SIZE - idx * BUFFER_SIZE, static_cast<uint32_t>(BUFFER_SIZE));
-        const HalStatus ret = READ(addr + idx * BUFFER_SIZE, buffer, sz);
-        if (ret != HalStatus::HAL_OK) return LX_ERROR;
-        for (const uint8_t c: buffer) {
-            if (c != 0xFF) return LX_ERROR;
+    const bool suspended = beginAccess(addr, SECTOR_SIZE);
+    const auto ret = checkErased(addr, SECTOR_SIZE);
+    endAccess(suspended);
+    return ret == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+}
+
+HalStatus Sst26Driver::checkErased(const uint32_t addr, const uint32_t size) {
+    // Word aligned, so erased memory can be compared word by word
+    uint32_t buffer[ERASE_CHECK_CHUNK_SIZE / sizeof(uint32_t)];
+    const auto bytes = reinterpret_cast<uint8_t *>(buffer);
+
+    spi->select();
+    auto ret = transmitReadHeader(getEffectiveReadMode(), addr);
+    for (uint32_t offset = 0; offset < size && ret == HalStatus::HAL_OK; offset += ERASE_CHECK_CHUNK_SIZE) {
+        const auto sz = static_cast<uint16_t>(std::min(size - offset, ERASE_CHECK_CHUNK_SIZE));
+        ret = receiveData(bytes, sz);
+        if (ret != HalStatus::HAL_OK) break;
+
+        const uint16_t words = sz / sizeof(uint32_t);
+        for (uint16_t i = 0; i < words && ret == HalStatus::HAL_OK; i++) {
+            if (buffer[i] != 0xFFFFFFFF) ret = HalStatus::HAL_ERROR;
+        }
+        for (uint16_t i = words * sizeof(uint32_t); i < sz && ret == HalStatus::HAL_OK; i++) {
+            if (bytes[i] != 0xFF) ret = HalStatus::HAL_ERROR;
         }
     }
-
-    return LX_SUCCESS;
+    // Ends the read early on the first programmed bit
+    spi->unselect();
+    return ret;
 }
 
 UINT Sst26Driver::initialize() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::initialize()\r\n");
 
+    // The reset would abort an erase or a page program that another thread has left running
+    beginAccess(0, 0);
+    // The device may still be in SQI mode if only the MCU has been reset
+    if (spi->getMaxLanes() >= 4) RSTQIO();
     reset();
-    if (waitForComOk(40) != HalStatus::HAL_OK) return LX_ERROR;
-    WREN();
-    ULBPR();
-    WRDI();
-    return LX_SUCCESS;
+    UINT ret = waitForComOk(40) == HalStatus::HAL_OK ? LX_SUCCESS : LX_ERROR;
+    if (ret == LX_SUCCESS) {
+        // The SST26VF016B, 032B and 064B only differ in their size
+        totalSize = sfdp.read(spi) == HalStatus::HAL_OK && sfdp.getDensity() > 0
+                        ? sfdp.getDensity()
+                        : DEFAULT_TOTAL_SIZE;
+        if (sfdp.isValid() && sfdp.getPageSize() != PAGE_SIZE) {
+            LIBSMART_STM32LEVELX_LOG(log(), WARNING)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::initialize() page size %lu\r\n", sfdp.getPageSize());
+        }
+        WREN();
+        ULBPR();
+        WRDI();
+        // SQOR, SQIOR and SQPP need SIO2 and SIO3
+        if (spi->getMaxLanes() >= 4 && setIOC(true) != HalStatus::HAL_OK) ret = LX_ERROR;
+    }
+    endAccess(false);
+    return ret;
 }
 
 UINT Sst26Driver::reset() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::Driver::Sst26Driver::reset()\r\n");
     RSTEN();
     RST();
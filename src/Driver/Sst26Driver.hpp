@@ -11,7 +11,15 @@
 #include <main.h>
 
 #include "../AbstractNorDriver.hpp"
-#include "Stm32Spi.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+#include "../Crc32.hpp"
+#include "Sfdp.hpp"
+#include "Transport/AbstractSpiTransport.hpp"
+
+#ifndef LIBSMART_STM32LEVELX_VERIFY_POLICY
+#define LIBSMART_STM32LEVELX_VERIFY_POLICY FULL
+#endif
 
 using namespace Stm32Common;
 
@@ -22,10 +30,10 @@ namespace Stm32LevelX::Driver {
      */
     class Sst26Driver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
     public:
-        explicit Sst26Driver(Stm32Spi::Spi *spi)
+        explicit Sst26Driver(AbstractSpiTransport *spi)
             : spi(spi) { ; }
 
-        Sst26Driver(Stm32Spi::Spi *spi, Stm32ItmLogger::LoggerInterface *logger)
+        Sst26Driver(AbstractSpiTransport *spi, Stm32ItmLogger::LoggerInterface *logger)
             : Loggable(logger),
               spi(spi) { ; }
 
@@ -33,6 +41,38 @@ namespace Stm32LevelX::Driver {
         static constexpr uint32_t PAGE_SIZE = 256;
         static constexpr uint32_t SECTOR_SIZE = 4096;
 
+        /**
+         * Size of the array until initialize() has read the BFPT, or if the device does not provide one.
+         * This is the size of the SST26VF016B.
+         */
+        static constexpr uint32_t DEFAULT_TOTAL_SIZE = 2 * 1024 * 1024;
+
+        /**
+         * Highest SPI clock for the READ instruction. All other read instructions run up to 104 MHz.
+         */
+        static constexpr uint32_t READ_MAX_CLOCK_HZ = 40000000;
+
+        /**
+         * Bytes checkErased() receives and compares at a time, while the chip select stays asserted.
+         */
+        static constexpr uint32_t ERASE_CHECK_CHUNK_SIZE = 256;
+
+        /**
+         * Bytes write() receives at a time while it reads back a page.
+         */
+        static constexpr uint16_t VERIFY_CHUNK_SIZE = 64;
+
+        /**
+         * Largest data phase handed to the transport at once. Longer reads continue in the same transaction.
+         */
+        static constexpr uint16_t MAX_TRANSFER_SIZE = 0x8000;
+
+        /**
+         * readv() reads the bytes between two segments and drops them if there are at most this many, instead
+         * of starting a new read command.
+         */
+        static constexpr uint32_t READV_MAX_GAP = 16;
+
         class JEDECID {
         public:
             static constexpr uint8_t BYTE_0 = 0xBF;
@@ -41,6 +81,9 @@ namespace Stm32LevelX::Driver {
             static constexpr uint8_t DEVICE_TYPE = BYTE_1;
             static constexpr uint8_t BYTE_2 = 0x41;
             static constexpr uint8_t DEVICE_ID = BYTE_2;
+            static constexpr uint8_t DEVICE_ID_SST26VF016B = 0x41;
+            static constexpr uint8_t DEVICE_ID_SST26VF032B = 0x42;
+            static constexpr uint8_t DEVICE_ID_SST26VF064B = 0x43;
         };
 
         class Instruction {
@@ -48,8 +91,8 @@ namespace Stm32LevelX::Driver {
             static constexpr uint8_t NOP = 0x00; ///< No Operation
             static constexpr uint8_t RSTEN = 0x66; ///< Reset Enable
             static constexpr uint8_t RST = 0x99; ///< Reset Memory
-            static constexpr uint8_t EQIO = 0x38; ///< Enable Quad I/O (NOT IMPLEMENTED)
-            static constexpr uint8_t RSTQIO = 0xFF; ///< Reset Quad I/O (NOT IMPLEMENTED)
+            static constexpr uint8_t EQIO = 0x38; ///< Enable Quad I/O
+            static constexpr uint8_t RSTQIO = 0xFF; ///< Reset Quad I/O
             static constexpr uint8_t RDSR = 0x05; ///< Read Status Register
             static constexpr uint8_t WRSR = 0x01; ///< Write Status Register
             static constexpr uint8_t RDCR = 0x35; ///< Read Configuration Register
@@ -121,6 +164,40 @@ namespace Stm32LevelX::Driver {
             EUI64_OCTET0 = 0x26F,
         };
 
+        /**
+         * @brief Instruction used by read() and the other memory reads of the AbstractNorDriver interface.
+         */
+        enum class ReadMode : uint8_t {
+            AUTO, ///< Chosen from the SPI clock and the data lanes of the transport, see getEffectiveReadMode()
+            READ, ///< 0x03, no dummy cycles, up to 40 MHz
+            READ_HS, ///< 0x0B, 8 dummy cycles
+            SDOR, ///< 0x3B, 8 dummy cycles, data on 2 lanes
+            SDIOR, ///< 0xBB, address, mode bits and data on 2 lanes
+            SQOR, ///< 0x6B, 8 dummy cycles, data on 4 lanes
+            SQIOR, ///< 0xEB, address, mode bits, 4 dummy cycles and data on 4 lanes
+        };
+
+        /**
+         * @brief How write() checks a page after programming it.
+         *
+         * The default is set with LIBSMART_STM32LEVELX_VERIFY_POLICY, e.g.
+         * `#define LIBSMART_STM32LEVELX_VERIFY_POLICY CRC32`.
+         */
+        enum class VerifyPolicy : uint8_t {
+            OFF, ///< Pages are not read back
+            FULL, ///< Pages are read back and compared byte by byte, stopping at the first difference
+            CRC32, ///< Pages are read back and their CRC is compared to the CRC of the data, see Crc32
+        };
+
+        /**
+         * @brief Instruction used by write() to program a page.
+         */
+        enum class ProgramMode : uint8_t {
+            AUTO, ///< SQPP if the transport has 4 data lanes, PP otherwise
+            PP, ///< 0x02, address and data on a single lane
+            SQPP, ///< 0x32, address and data on 4 lanes
+        };
+
 
         /**
          * @brief No Operation.
@@ -128,7 +205,7 @@ namespace Stm32LevelX::Driver {
          * @return The result of the transmit operation.
          */
         HalStatus NOP() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::NOP()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::NOP);
@@ -143,7 +220,7 @@ namespace Stm32LevelX::Driver {
          * @returns The return value of the spi->transmit() method, which is the result of the RSTEN command.
          */
         HalStatus RSTEN() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RSTEN()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RSTEN);
@@ -158,7 +235,7 @@ namespace Stm32LevelX::Driver {
          * @return The status of the operation.
          */
         HalStatus RST() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RST()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RST);
@@ -167,6 +244,43 @@ namespace Stm32LevelX::Driver {
         }
 
 
+        /**
+         * @brief Enable Quad I/O.
+         *
+         * Switches the device into SQI mode, where instruction, address and data all use 4 lanes. The other
+         * primitives of this driver use SPI mode, call RSTQIO() before using them again.
+         *
+         * @return The result of the transmit operation.
+         */
+        HalStatus EQIO() {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::EQIO()\r\n");
+            spi->select();
+            auto ret = spi->transmit(Instruction::EQIO);
+            spi->unselect();
+            return ret;
+        }
+
+
+        /**
+         * @brief Reset Quad I/O.
+         *
+         * Returns the device from SQI mode to SPI mode. The instruction is sent on 4 lanes, so the transport must
+         * support them. A device that already is in SPI mode ignores it.
+         *
+         * @return The result of the transmit operation.
+         */
+        HalStatus RSTQIO() {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::RSTQIO()\r\n");
+            spi->select();
+            auto ret = spi->setLanes(4);
+            ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(Instruction::RSTQIO);
+            spi->unselect();
+            return ret;
+        }
+
+
         /**
          * @brief Read the status register of the SST26 flash driver.
          *
@@ -180,7 +294,7 @@ namespace Stm32LevelX::Driver {
          * @return The HAL status indicating the success or failure of the operation.
          */
         HalStatus RDSR(uint8_t &statusRegister) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RDSR()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RDSR);
@@ -210,6 +324,18 @@ namespace Stm32LevelX::Driver {
         [[nodiscard]] bool isWPLD() { return (RDSR() & 1 << 4) > 0; }
         [[nodiscard]] bool isSEC() { return (RDSR() & 1 << 5) > 0; }
 
+        /**
+         * Number of status register reads suspendErase() waits for the device to enter the suspend state.
+         * Tws is 10 us, one read takes 16 SPI clocks.
+         */
+        static constexpr uint16_t SUSPEND_POLL_LIMIT = 1000;
+
+        /**
+         * Number of times one erase may be suspended. Reads after that wait for the erase, so a steady stream of
+         * reads cannot keep it suspended, and the time waitForErase() waits is bounded.
+         */
+        static constexpr uint8_t MAX_SUSPENSIONS_PER_ERASE = 16;
+
 
         /**
          * @brief Waits for the write operation to finish within the specified timeout period.
@@ -258,7 +384,7 @@ namespace Stm32LevelX::Driver {
          *         - Other HalStatus values: Operation unsuccessful, refer to the HalStatus documentation for detailed error codes.
          */
         HalStatus WRSR(const uint8_t statusRegister, const uint8_t configurationRegister) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::WRSR(0x%02x, 0x%02x)\r\n",
                              statusRegister, configurationRegister);
             spi->select();
@@ -281,7 +407,7 @@ namespace Stm32LevelX::Driver {
          * @return The status of the operation. Returns HalStatus::HAL_OK if successful, else an error status.
          */
         HalStatus RDCR(uint8_t &configurationRegister) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RDCR()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RDCR);
@@ -309,6 +435,32 @@ namespace Stm32LevelX::Driver {
         [[nodiscard]] bool isWPEN() { return (RDCR() & 1 << 7) > 0; }
 
 
+        /**
+         * @brief Sets or clears the IOC bit of the configuration register.
+         *
+         * With IOC set, WP# and HOLD# are disabled and the pins work as SIO2 and SIO3. The SPI quad instructions
+         * SQOR, SQIOR and SQPP need this.
+         *
+         * @param enable true to set IOC.
+         * @return The status of the operation.
+         */
+        HalStatus setIOC(const bool enable) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::setIOC(%d)\r\n", enable);
+            uint8_t configurationRegister;
+            auto ret = RDCR(configurationRegister);
+            if (ret != HalStatus::HAL_OK) return ret;
+            const uint8_t value = enable
+                                      ? configurationRegister | 1 << 1
+                                      : configurationRegister & ~(1 << 1);
+            if (value == configurationRegister) return HalStatus::HAL_OK;
+            ret = WREN();
+            ret = ret != HalStatus::HAL_OK ? ret : WRSR(0x00, value);
+            ret = ret != HalStatus::HAL_OK ? ret : waitForWriteFinish(1);
+            return ret;
+        }
+
+
         /**
          * @brief Read data from a specific address.
          *
@@ -323,13 +475,13 @@ namespace Stm32LevelX::Driver {
          * @return The status of the operation (HalStatus::HAL_OK if successful, an error code otherwise).
          */
         HalStatus READ(const uint32_t addr, uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::READ(0x%08x, %p, %lu)\r\n",
                              addr, &pData, size);
             spi->select();
             // memset(pData, 0, size);
             auto ret = spi->transmit_be((Instruction::READ << 24) | (addr & 0x00FFFFFF));
-            ret = ret != HalStatus::HAL_OK ? ret : spi->receive(pData, size);
+            ret = ret != HalStatus::HAL_OK ? ret : receiveData(pData, size);
             spi->unselect();
             return ret;
         }
@@ -352,19 +504,132 @@ namespace Stm32LevelX::Driver {
          *         - Other values: If the read operation fails.
          */
         HalStatus READ_HS(const uint32_t addr, uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::READ_HS(0x%08x, %p, %lu)\r\n",
                              addr, &pData, size);
             spi->select();
             // memset(pData, 0, size);
             auto ret = spi->transmit(Instruction::READ_HS);
             ret = ret != HalStatus::HAL_OK ? ret : spi->transmit_be(addr << 8 | 0xFF);
-            ret = ret != HalStatus::HAL_OK ? ret : spi->receive(pData, size);
+            ret = ret != HalStatus::HAL_OK ? ret : receiveData(pData, size);
             spi->unselect();
             return ret;
         }
 
 
+        /**
+         * @brief Read data from a specific address using SPI Dual Output Read.
+         *
+         * The instruction, the address and 8 dummy cycles are transmitted on a single lane, the data is
+         * received on SIO0 and SIO1. The transport must support 2 data lanes.
+         *
+         * @param addr The address to read from.
+         * @param pData A pointer to the buffer where the read data will be stored.
+         * @param size The size of the data to read, in bytes.
+         *
+         * @return The status of the read operation.
+         */
+        HalStatus SDOR(const uint32_t addr, uint8_t *pData, const uint16_t size) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::SDOR(0x%08x, %p, %lu)\r\n",
+                             addr, &pData, size);
+            return readMemory(ReadMode::SDOR, addr, pData, size);
+        }
+
+
+        /**
+         * @brief Read data from a specific address using SPI Dual I/O Read.
+         *
+         * The instruction is transmitted on a single lane. The address, the mode bits and the data use SIO0 and
+         * SIO1. The mode bits are sent as 0xFF, so the device does not enter continuous read mode. The transport
+         * must support 2 data lanes.
+         *
+         * @param addr The address to read from.
+         * @param pData A pointer to the buffer where the read data will be stored.
+         * @param size The size of the data to read, in bytes.
+         *
+         * @return The status of the read operation.
+         */
+        HalStatus SDIOR(const uint32_t addr, uint8_t *pData, const uint16_t size) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::SDIOR(0x%08x, %p, %lu)\r\n",
+                             addr, &pData, size);
+            return readMemory(ReadMode::SDIOR, addr, pData, size);
+        }
+
+
+        /**
+         * @brief Read data from a specific address using SPI Quad Output Read.
+         *
+         * The instruction, the address and 8 dummy cycles are transmitted on a single lane, the data is
+         * received on SIO0 to SIO3. The transport must support 4 data lanes and the IOC bit must be set.
+         *
+         * @param addr The address to read from.
+         * @param pData A pointer to the buffer where the read data will be stored.
+         * @param size The size of the data to read, in bytes.
+         *
+         * @return The status of the read operation.
+         * @see Sst26Driver::setIOC()
+         */
+        HalStatus SQOR(const uint32_t addr, uint8_t *pData, const uint16_t size) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::SQOR(0x%08x, %p, %lu)\r\n",
+                             addr, &pData, size);
+            return readMemory(ReadMode::SQOR, addr, pData, size);
+        }
+
+
+        /**
+         * @brief Read data from a specific address using SPI Quad I/O Read.
+         *
+         * The instruction is transmitted on a single lane. The address, the mode bits, 4 dummy cycles and the
+         * data use SIO0 to SIO3. The mode bits are sent as 0xFF, so the device does not enter continuous read
+         * mode. The transport must support 4 data lanes and the IOC bit must be set.
+         *
+         * @param addr The address to read from.
+         * @param pData A pointer to the buffer where the read data will be stored.
+         * @param size The size of the data to read, in bytes.
+         *
+         * @return The status of the read operation.
+         * @see Sst26Driver::setIOC()
+         */
+        HalStatus SQIOR(const uint32_t addr, uint8_t *pData, const uint16_t size) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::SQIOR(0x%08x, %p, %lu)\r\n",
+                             addr, &pData, size);
+            return readMemory(ReadMode::SQIOR, addr, pData, size);
+        }
+
+
+        /**
+         * @brief Read data from a specific address with the given read instruction.
+         *
+         * @param mode Instruction to use. AUTO uses getEffectiveReadMode().
+         * @param addr The address to read from.
+         * @param pData A pointer to the buffer where the read data will be stored.
+         * @param size The size of the data to read, in bytes.
+         *
+         * @return The status of the read operation.
+         */
+        HalStatus readMemory(ReadMode mode, uint32_t addr, uint8_t *pData, size_t size);
+
+
+        /**
+         * @brief Checks if a memory range is erased.
+         *
+         * The range is read in a single transaction. The data is received in chunks of ERASE_CHECK_CHUNK_SIZE
+         * bytes, by DMA if the chunk reaches the DMA threshold, and compared word by word against 0xFFFFFFFF.
+         * The read ends at the first chunk that holds a programmed bit.
+         *
+         * @param addr The address of the range.
+         * @param size The size of the range, in bytes.
+         *
+         * @return HalStatus::HAL_OK if all bytes are 0xFF, HalStatus::HAL_ERROR if not, or the error of the
+         *         transfer.
+         */
+        HalStatus checkErased(uint32_t addr, uint32_t size);
+
+
         /**
          * @brief Write Enable (WREN)
          *
@@ -391,7 +656,7 @@ namespace Stm32LevelX::Driver {
          *         - `HalStatus::HAL_ERROR` if the write enable operation failed
          */
         HalStatus WREN() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::WREN()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::WREN);
@@ -408,7 +673,7 @@ namespace Stm32LevelX::Driver {
          * @return HalStatus::HAL_OK if the Write Enable Latch (WEL) bit is successfully cleared, HalStatus::HAL_ERROR otherwise.
          */
         HalStatus WRDI() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::WRDI()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::WRDI);
@@ -434,7 +699,7 @@ namespace Stm32LevelX::Driver {
          * @see Sst26Driver::waitForWriteFinish()
          */
         HalStatus SE(const uint32_t addr) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::SE(0x%08x)\r\n",
                              addr);
 
@@ -447,6 +712,63 @@ namespace Stm32LevelX::Driver {
         }
 
 
+        /**
+         * @brief Erase a block of the flash memory.
+         *
+         * The size of the block depends on its address, see getEraseBlockSize(). The address must be aligned
+         * with the size of the block.
+         *
+         * @param addr The address of the block to be erased.
+         *
+         * @return The status of the operation, indicating if the erase was successful.
+         *         Possible values are:
+         *         - HalStatus::HAL_OK: The erase operation was successful.
+         *         - HalStatus::HAL_ERROR: The erase operation failed.
+         *
+         * @note Wait until device is ready after this command. Tbe = 25ms
+         * @see Sst26Driver::waitForWriteFinish()
+         */
+        HalStatus BE(const uint32_t addr) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::BE(0x%08x)\r\n",
+                             addr);
+
+            if (!isWEL()) return HalStatus::HAL_ERROR;
+            if (addr % getEraseBlockSize(addr) > 0) return HalStatus::HAL_ERROR;
+            spi->select();
+            const auto ret = spi->transmit_be((Instruction::BE << 24) | (addr & 0x00FFFFFF));
+            spi->unselect();
+            return ret;
+        }
+
+
+        /**
+         * @brief Suspends a running sector or block erase.
+         *
+         * The device accepts all read commands while the erase is suspended, except for addresses in the
+         * sector or block being erased. The suspend state is entered within Tws = 10 us, see isWSE().
+         *
+         * @return The status of the SPI transfer.
+         */
+        HalStatus WRSU() {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::WRSU()\r\n");
+            return transmitInstruction(Instruction::WRSU);
+        }
+
+
+        /**
+         * @brief Resumes an erase that has been suspended with WRSU().
+         *
+         * @return The status of the SPI transfer.
+         */
+        HalStatus WRRE() {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::WRRE()\r\n");
+            return transmitInstruction(Instruction::WRRE);
+        }
+
+
         /**
          * @brief Sends the Erase Full Array command.
          *
@@ -462,7 +784,7 @@ namespace Stm32LevelX::Driver {
          * @see Sst26Driver::waitForWriteFinish()
          */
         HalStatus CE() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::CE()\r\n");
 
             if (!isWEL()) return HalStatus::HAL_ERROR;
@@ -491,38 +813,42 @@ namespace Stm32LevelX::Driver {
          * @see Sst26Driver::waitForWriteFinish()
          */
         HalStatus PP(const uint32_t addr, uint8_t *in, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::PP(0x%08x, %p, %lu)\r\n",
                              addr, &in, size);
             if (!isWEL()) return HalStatus::HAL_ERROR;
             if (size > PAGE_SIZE) return HalStatus::HAL_ERROR;
             if (size <= 0) return HalStatus::HAL_ERROR;
-            const auto sz = std::min(size, static_cast<uint16_t>(PAGE_SIZE - (addr & 0x000000FF)));
-            spi->select();
-            auto ret = spi->transmit_be(Instruction::PP << 24 | addr & 0x00FFFFFF);
-            ret = ret != HalStatus::HAL_OK ? ret : spi->transmit(in, sz);
-            spi->unselect();
-            if (ret != HalStatus::HAL_OK) return ret;
-
-
-            // Check written bytes
-#ifdef LIBSMART_STM32LEVELX_PP_READ_BACK_TEST
-
-            waitForWriteFinish(3);
-            constexpr uint16_t BUFFER_SIZE = 32;
-            uint8_t buffer[BUFFER_SIZE] = {};
-            const uint16_t SLICES = (size + BUFFER_SIZE - 1) / BUFFER_SIZE;
-
-            for (uint16_t iSlice = 0; iSlice < SLICES; iSlice++) {
-                const uint16_t sz = std::min(static_cast<uint16_t>(size - iSlice * BUFFER_SIZE), BUFFER_SIZE);
-                const HalStatus ret = READ(addr + iSlice * BUFFER_SIZE, buffer, sz);
-                if (ret != HalStatus::HAL_OK) return ret;
-                if (std::memcmp(buffer, &in[iSlice * BUFFER_SIZE], sz) != 0) return HalStatus::HAL_ERROR;
-            }
+            return transmitProgram(ProgramMode::PP, addr, in, size);
+        }
 
-#endif
 
-            return ret;
+        /**
+         * @brief Program a page (256 bytes) of data to the specified address using SPI Quad Page Program.
+         *
+         * The instruction is transmitted on a single lane, the address and the data on SIO0 to SIO3. The
+         * transport must support 4 data lanes and the IOC bit must be set.
+         *
+         * @param addr The address to program the data to.
+         * @param in A pointer to the data to program.
+         * @param size The size of the data to program in bytes.
+         *
+         * @return A HalStatus value indicating the success or failure of the operation.
+         *         - HAL_OK: Operation was successful.
+         *         - HAL_ERROR: WEL flag is not set, size is greater than 256 or the transport has less than
+         *           4 data lanes.
+         *
+         * @note Wait until device is ready after this command. Tpp = 1.5ms
+         * @see Sst26Driver::waitForWriteFinish()
+         */
+        HalStatus SQPP(const uint32_t addr, uint8_t *in, const uint16_t size) {
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+                    ->printf("Stm32LevelX::Driver::Sst26Driver::SQPP(0x%08x, %p, %lu)\r\n",
+                             addr, &in, size);
+            if (!isWEL()) return HalStatus::HAL_ERROR;
+            if (size > PAGE_SIZE) return HalStatus::HAL_ERROR;
+            if (size <= 0) return HalStatus::HAL_ERROR;
+            return transmitProgram(ProgramMode::SQPP, addr, in, size);
         }
 
 
@@ -534,7 +860,7 @@ namespace Stm32LevelX::Driver {
          * @return A `HalStatus` value representing the status of the operation.
          */
         HalStatus RDID(uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RDID()\r\n");
             if (size < 3) return HalStatus::HAL_ERROR;
             spi->select();
@@ -558,7 +884,7 @@ namespace Stm32LevelX::Driver {
          * @return A `HalStatus` value representing the status of the operation.
          */
         HalStatus SFDP(const uint32_t addr, uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::SFDP(0x%08x, %p, %lu)\r\n",
                              addr, &pData, size);
             spi->select();
@@ -625,7 +951,7 @@ namespace Stm32LevelX::Driver {
          * @return The current Block Protection Register (BPR) value.
          */
         HalStatus RBPR(uint8_t *out, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RBPR()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RBPR);
@@ -644,7 +970,7 @@ namespace Stm32LevelX::Driver {
          * @see WREN()
          */
         HalStatus ULBPR() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::ULBPR()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::ULBPR);
@@ -662,7 +988,7 @@ namespace Stm32LevelX::Driver {
          * @return A `HalStatus` value representing the status of the operation.
          */
         HalStatus RSID(uint16_t addr, uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RSID(0x%08x, %p, %lu)\r\n",
                              addr, &pData, size);
             spi->select();
@@ -682,7 +1008,7 @@ namespace Stm32LevelX::Driver {
          * @return The status of the DPD transmission: `HalStatus`
          */
         HalStatus DPD() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::DPD()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::DPD);
@@ -697,7 +1023,7 @@ namespace Stm32LevelX::Driver {
          * @return The HalStatus indicating the success or failure of the RDPD operation.
          */
         HalStatus RDPD() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::RDPD()\r\n");
             spi->select();
             auto ret = spi->transmit(Instruction::RDPD);
@@ -715,13 +1041,14 @@ namespace Stm32LevelX::Driver {
          * @return True if the communication with the flash device is OK, false otherwise.
          */
         bool isComOk() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::isComOk()\r\n");
             uint8_t jedecId[3] = {};
             RDID(jedecId, sizeof(jedecId));
             return (jedecId[0] == JEDECID::BYTE_0)
                    && (jedecId[1] == JEDECID::BYTE_1)
-                   && (jedecId[2] == JEDECID::BYTE_2);
+                   && (jedecId[2] >= JEDECID::DEVICE_ID_SST26VF016B)
+                   && (jedecId[2] <= JEDECID::DEVICE_ID_SST26VF064B);
         }
 
 
@@ -771,7 +1098,7 @@ namespace Stm32LevelX::Driver {
          * @return A `HalStatus` value representing the status of the operation:
          */
         HalStatus getEUI48(uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::getEUI48()\r\n");
             if (size < 6) return HalStatus::HAL_ERROR;
             // memset(pData, 0, size);
@@ -793,7 +1120,7 @@ namespace Stm32LevelX::Driver {
          * @return A `HalStatus` value representing the status of the operation:
          */
         HalStatus getEUI64(uint8_t *pData, const uint16_t size) {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Driver::Sst26Driver::getEUI64()\r\n");
             if (size < 8) return HalStatus::HAL_ERROR;
             // memset(pData, 0, size);
@@ -803,11 +1130,127 @@ namespace Stm32LevelX::Driver {
             return HalStatus::HAL_ERROR;
         }
 
+        /**
+         * @brief Sets the transfer size from which reads use DMA.
+         *
+         * Reads of at least this many bytes block the calling thread until the DMA transfer has finished,
+         * so other threads get the CPU in the meantime. Shorter reads are polled, because the DMA setup
+         * costs more than it saves.
+         *
+         * @param threshold Minimum number of bytes for a DMA read. 0 disables DMA.
+         */
+        void setDmaThreshold(const uint16_t threshold) { dmaThreshold = threshold; }
+
+        [[nodiscard]] uint16_t getDmaThreshold() const { return dmaThreshold; }
+
+        /**
+         * @brief Sets the instruction used by read(), readAsync(), write() and verifySectorErased().
+         *
+         * SDOR and SDIOR need a transport with at least 2 data lanes, SQOR and SQIOR one with 4.
+         */
+        void setReadMode(const ReadMode mode) { readMode = mode; }
+
+        [[nodiscard]] ReadMode getReadMode() const { return readMode; }
+
+        /**
+         * @brief Returns the instruction that is actually used for reads.
+         *
+         * In AUTO mode, SQIOR is used if the transport has 4 data lanes and SDIOR if it has 2. On a single
+         * lane, READ is used if the SPI clock is known and does not exceed READ_MAX_CLOCK_HZ, otherwise READ_HS.
+         */
+        [[nodiscard]] ReadMode getEffectiveReadMode() const;
+
+        /**
+         * @brief Sets the instruction used by write(). SQPP needs a transport with 4 data lanes.
+         */
+        void setProgramMode(const ProgramMode mode) { programMode = mode; }
+
+        [[nodiscard]] ProgramMode getProgramMode() const { return programMode; }
+
+        /**
+         * @brief Returns the instruction that is actually used by write().
+         */
+        [[nodiscard]] ProgramMode getEffectiveProgramMode() const {
+            if (programMode != ProgramMode::AUTO) return programMode;
+            return spi->getMaxLanes() >= 4 ? ProgramMode::SQPP : ProgramMode::PP;
+        }
+
+        /**
+         * @brief Enables or disables the lean program pipeline of write().
+         *
+         * With the pipeline enabled, write() does not read back the WEL bit after WREN and before the page
+         * program, and does not send WRDI at the end. WEL is cleared by the device when the page program
+         * completes. The only status reads left are the ones that wait for the page program to finish, plus one
+         * WEL read after WREN with VerifyPolicy::OFF, where no read back would notice a lost WREN.
+         * Enabled by default.
+         */
+        void setProgramPipeline(const bool enable) { programPipeline = enable; }
+
+        [[nodiscard]] bool isProgramPipeline() const { return programPipeline; }
+
+        /**
+         * @brief Returns the number of SPI transactions the program pipeline has saved since the last reset.
+         */
+        [[nodiscard]] uint32_t getSavedTransactions() const { return savedTransactions; }
+
+        void resetSavedTransactions() { savedTransactions = 0; }
+
+        /**
+         * @brief Sets how write() checks the pages it has programmed.
+         */
+        void setVerifyPolicy(const VerifyPolicy policy) { verifyPolicy = policy; }
+
+        [[nodiscard]] VerifyPolicy getVerifyPolicy() const { return verifyPolicy; }
+
+        /**
+         * @brief Enables or disables the suspension of erases by read() and verifySectorErased().
+         *
+         * Erases are started by eraseSector() and eraseRange(), which release the transport lock while they
+         * wait for the device. A read from another thread that arrives in the meantime suspends a sector or
+         * block erase with WRSU, reads and resumes the erase with WRRE. Without erase suspend, during a chip
+         * erase, or after MAX_SUSPENSIONS_PER_ERASE suspensions of the same erase, the read waits until the erase
+         * has finished. Enabled by default.
+         */
+        void setEraseSuspend(const bool enable) { eraseSuspend = enable; }
+
+        [[nodiscard]] bool isEraseSuspend() const { return eraseSuspend; }
+
+        /**
+         * @brief Returns the number of erases that have been suspended for a read since the last reset.
+         */
+        [[nodiscard]] uint32_t getEraseSuspensions() const { return eraseSuspensions; }
+
+        void resetEraseSuspensions() { eraseSuspensions = 0; }
+
+        /**
+         * @brief Returns the name of a read mode, e.g. for log output.
+         */
+        static const char *getReadModeName(ReadMode mode);
+
+        /**
+         * @brief Returns the size of the block BE() erases at the given address.
+         *
+         * The array starts and ends with four 8 KByte blocks, followed by one 32 KByte block on each side.
+         * Everything in between is made of 64 KByte blocks.
+         */
+        [[nodiscard]] uint32_t getEraseBlockSize(uint32_t addr);
+
+        /**
+         * @brief Returns the size of the array in bytes, as read from the BFPT by initialize().
+         */
+        [[nodiscard]] uint32_t getTotalSize() const { return totalSize; }
+
+        /**
+         * @brief Returns the SFDP parameters read by initialize().
+         */
+        [[nodiscard]] const Sfdp &getSfdp() const { return sfdp; }
+
     public:
         /**
          * @brief Retrieves the total number of sectors in the SST26 flash device.
          *
-         * This function returns the total number of sectors in the SST26 flash device.
+         * This function returns the total number of sectors in the SST26 flash device. The size of the device is
+         * taken from the SFDP density by initialize(), see DEFAULT_TOTAL_SIZE.
          *
          * @return The total number of sectors in the SST26 flash device.
          */
@@ -837,8 +1280,38 @@ namespace Stm32LevelX::Driver {
          *
          * @return Upon successful completion, the function returns LX_SUCCESS.
          *         If an error occurs during the read operation, LX_ERROR is returned.
+         * @note If another thread is waiting for an erase, the erase is suspended, see setEraseSuspend().
          */
-        UINT read(uint32_t addr, uint8_t *out, uint16_t size) override;
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+
+        /**
+         * @brief Reads several ranges with as few read commands as possible.
+         *
+         * Segments that follow each other in ascending order, with gaps of at most READV_MAX_GAP bytes, are read
+         * in one transaction. The header, the free bitmap and the mapping list of a LevelX block take one
+         * command this way instead of three.
+         */
+        UINT readv(const Segment *segments, size_t count) override;
+
+
+        /**
+         * @brief Starts reading data from the specified address and returns immediately.
+         *
+         * The data phase runs by DMA if the transport supports it. The read takes the transport lock and hands
+         * it over to the transfer, so other threads wait in lock() until the callback has returned. The read
+         * does not wait for or suspend a pending program or erase; the call fails while one is pending, and
+         * read() can be used instead.
+         *
+         * @param addr The address to read data from.
+         * @param out Pointer to the buffer where the read data will be stored.
+         * @param size The number of bytes to read from the specified address.
+         * @param callback Called with LX_SUCCESS or LX_ERROR when the transfer has finished.
+         * @param context Passed to the callback.
+         * @return LX_SUCCESS if the read has been started, LX_ERROR otherwise. The callback is only called
+         * after LX_SUCCESS.
+         */
+        UINT readAsync(uint32_t addr, uint8_t *out, size_t size, ReadCallback callback, void *context) override;
 
 
         /**
@@ -853,7 +1326,7 @@ namespace Stm32LevelX::Driver {
          *
          * @return Returns an @c UINT value indicating the status of the write operation.
          */
-        UINT write(uint32_t addr, uint8_t *in, uint16_t size) override;
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
 
 
         /**
@@ -861,6 +1334,7 @@ namespace Stm32LevelX::Driver {
          *
          * This method erases a sector of the SST26 flash device at the specified address.
          * The erase count specifies how many times the sector has been erased.
+         * The method returns when the device has finished the erase.
          *
          * @param addr The address of the sector to be erased.
          * @param erase_count The number of times the sector was erased.
@@ -870,10 +1344,43 @@ namespace Stm32LevelX::Driver {
         UINT eraseSector(uint32_t addr, ULONG erase_count) override;
 
 
+        /**
+         * @brief Erases a range of sectors with as few erase commands as possible.
+         *
+         * The whole array is erased with CE(). Otherwise every block of the range that is covered completely
+         * is erased with BE(), the rest sector by sector with SE(). The method returns when the device has
+         * finished the last erase.
+         *
+         * @param addr Start address, aligned to SECTOR_SIZE.
+         * @param size Number of bytes, a multiple of SECTOR_SIZE.
+         * @return LX_SUCCESS, or LX_ERROR if the range is not aligned, exceeds the array or an erase failed.
+         */
+        UINT eraseRange(uint32_t addr, uint32_t size) override;
+
+
+        /**
+         * @brief Programs all pages but the last one like write() and starts programming the last one.
+         */
+        UINT startWrite(uint32_t addr, uint8_t *in, size_t size) override;
+
+
+        /**
+         * @brief Sends SE and returns while the device is erasing.
+         */
+        UINT startEraseSector(uint32_t addr, ULONG erase_count) override;
+
+
+        /**
+         * @brief Waits for the erase or the last page program and verifies the page.
+         */
+        UINT finish() override;
+
+
         /**
          * @brief Verifies if a block of memory is erased.
          *
          * This method checks if the block of memory starting at the specified address is erased.
+         * The sector is read in a single transaction, see checkErased().
          *
          * @param addr The starting address of the block of memory.
          * @return LX_SUCCESS if the block is erased, LX_ERROR if it is not erased or an error occurs.
@@ -882,6 +1389,12 @@ namespace Stm32LevelX::Driver {
         UINT verifySectorErased(uint32_t addr) override;
 
 
+        /**
+         * @brief Resets the device, reads its size from the SFDP and removes the global block protection.
+         *
+         * The transport lock is held throughout. An erase or page program another thread has left running is
+         * waited for first, so the reset does not abort it.
+         */
         UINT initialize() override;
 
         /**
@@ -892,7 +1405,124 @@ namespace Stm32LevelX::Driver {
         UINT reset() override;
 
     protected:
-        Stm32Spi::Spi *spi;
+        /**
+         * @brief Receives the data phase of a read command, by DMA if the transfer is large enough.
+         */
+        HalStatus receiveData(uint8_t *pData, const uint16_t size) {
+            if (dmaThreshold > 0 && size >= dmaThreshold) return spi->receiveDma(pData, size);
+            return spi->receive(pData, size);
+        }
+
+        /**
+         * @brief Transmits instruction, address and dummy cycles of a read and switches to the data lanes.
+         */
+        HalStatus transmitReadHeader(ReadMode mode, uint32_t addr);
+
+        /**
+         * @brief Sends a command that consists of the instruction only.
+         */
+        HalStatus transmitInstruction(uint8_t instruction) {
+            spi->select();
+            const auto ret = spi->transmit(instruction);
+            spi->unselect();
+            return ret;
+        }
+
+        /**
+         * @brief Sends a PP or SQPP command without checking WEL. Data beyond the end of the page is dropped.
+         */
+        HalStatus transmitProgram(ProgramMode mode, uint32_t addr, uint8_t *in, uint16_t size);
+
+        /**
+         * @brief Programs one page as part of write(), using the program pipeline if it is enabled.
+         */
+        HalStatus programPage(uint32_t addr, uint8_t *in, uint16_t size);
+
+        /**
+         * @brief Reads back a programmed page in a single transaction and checks it according to the verify policy.
+         *
+         * @return LX_SUCCESS, LX_INVALID_WRITE if the page does not hold the data, or LX_ERROR if the read failed.
+         */
+        UINT verifyPage(uint32_t addr, const uint8_t *in, uint16_t size);
+
+        /**
+         * @brief Programs and verifies the pages of write().
+         */
+        UINT writePages(uint32_t addr, uint8_t *in, size_t size);
+
+        /**
+         * @brief Receives a data phase of any length, in parts of up to MAX_TRANSFER_SIZE bytes.
+         */
+        HalStatus receiveLong(uint8_t *pData, size_t size);
+
+        /**
+         * @brief Sends an SE, BE or CE command and waits until the device has finished the erase.
+         */
+        HalStatus eraseAndWait(uint8_t instruction, uint32_t addr, uint32_t timeout_ms) {
+            const auto ret = startErase(instruction, addr);
+            return ret != HalStatus::HAL_OK ? ret : waitForErase(timeout_ms);
+        }
+
+        /**
+         * @brief Sends an SE, BE or CE command and records it as the pending erase.
+         */
+        HalStatus startErase(uint8_t instruction, uint32_t addr);
+
+        /**
+         * @brief Polls the device until the pending erase has finished.
+         *
+         * The transport lock is only held while the status register is read, so reads of other threads can
+         * suspend the erase in between.
+         */
+        HalStatus waitForErase(uint32_t timeout_ms);
+
+        /**
+         * @brief Takes the transport lock and makes sure the device accepts reads.
+         *
+         * If another thread is waiting for an erase, the erase is suspended if possible. Otherwise the method
+         * waits until the erase has finished. A page program that startWrite() has left running is always
+         * waited for.
+         *
+         * @param addr Start of the range that is going to be read.
+         * @param size Size of the range, 0 to always wait for the erase, e.g. before a page program.
+         * @return true if an erase has been suspended and must be resumed by endAccess().
+         */
+        bool beginAccess(uint32_t addr, uint32_t size);
+
+        /**
+         * @brief Resumes a suspended erase and releases the transport lock.
+         */
+        void endAccess(bool suspended);
+
+        /**
+         * @brief Sends WRSU and waits until the device has entered the suspend state.
+         *
+         * @return true if the erase has been suspended, false if it had already finished.
+         */
+        bool suspendErase();
+
+        static void onReadAsyncComplete(HalStatus status, void *context);
+
+        AbstractSpiTransport *spi;
+        uint16_t dmaThreshold = 0;
+        ReadMode readMode = ReadMode::AUTO;
+        ProgramMode programMode = ProgramMode::AUTO;
+        bool programPipeline = true;
+        VerifyPolicy verifyPolicy = VerifyPolicy::LIBSMART_STM32LEVELX_VERIFY_POLICY;
+        uint32_t savedTransactions = 0;
+        bool eraseSuspend = true;
+        Sfdp sfdp;
+        uint32_t totalSize = DEFAULT_TOTAL_SIZE;
+        volatile uint8_t pendingErase = 0;
+        uint32_t pendingEraseAddr = 0;
+        uint32_t pendingEraseSize = 0;
+        uint8_t pendingEraseSuspensions = 0;
+        const uint8_t *pendingWriteData = nullptr;
+        uint32_t pendingWriteAddr = 0;
+        uint16_t pendingWriteSize = 0;
+        volatile uint32_t eraseSuspensions = 0;
+        volatile ReadCallback readAsyncCallback = nullptr;
+        void *readAsyncContext = nullptr;
     };
 }
 
@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "Stm32F4FlashDriver.hpp"
+
+using namespace Stm32LevelX::Driver;
+
+uint32_t Stm32F4FlashDriver::getTotalSize() const {
+    if (sectorCount == 0) return 0;
+    const uint8_t last = firstSector + sectorCount - 1;
+    return getFlashSectorOffset(last) + getFlashSectorSize(last) - getFlashSectorOffset(firstSector);
+}
+
+ULONG Stm32F4FlashDriver::getTotalSectors() {
+    return blockSize > 0 ? getTotalSize() / blockSize : 0;
+}
+
+ULONG Stm32F4FlashDriver::getSectorSize() {
+    return blockSize;
+}
+
+ULONG *Stm32F4FlashDriver::getBaseAddress() {
+#ifdef LIBSMART_STM32LEVELX_HAL_FLASH
+    return reinterpret_cast<ULONG *>(FLASH_BASE + getFlashSectorOffset(firstSector));
+#else
+    return reinterpret_cast<ULONG *>(memory);
+#endif
+}
+
+UINT Stm32F4FlashDriver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::read(0x%08x, %p, %lu)\r\n",
+                     addr, &out, size);
+
+    if (addr > getTotalSize() || size > getTotalSize() - addr) return LX_ERROR;
+    std::memcpy(out, reinterpret_cast<const uint8_t *>(getBaseAddress()) + addr, size);
+    return LX_SUCCESS;
+}
+
+UINT Stm32F4FlashDriver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::write(0x%08x, %p, %lu)\r\n",
+                     addr, &in, size);
+
+    if (addr > getTotalSize() || size > getTotalSize() - addr) return LX_ERROR;
+    const auto ret = program(addr, in, size);
+    if (ret != LX_SUCCESS) return ret;
+    return std::memcmp(reinterpret_cast<const uint8_t *>(getBaseAddress()) + addr, in, size) == 0
+               ? LX_SUCCESS
+               : LX_INVALID_WRITE;
+}
+
+UINT Stm32F4FlashDriver::eraseSector(const uint32_t addr, ULONG erase_count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::eraseSector(0x%08x)\r\n",
+                     addr);
+
+    return eraseRange(addr, blockSize);
+}
+
+UINT Stm32F4FlashDriver::eraseRange(const uint32_t addr, const uint32_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::eraseRange(0x%08x, %lu)\r\n",
+                     addr, size);
+
+    if (blockSize == 0 || addr % blockSize > 0 || size % blockSize > 0) return LX_ERROR;
+    if (addr > getTotalSize() || size > getTotalSize() - addr) return LX_ERROR;
+    if (size == 0) return LX_SUCCESS;
+
+    // Blocks always start at a sector, see initialize()
+    const uint8_t first = findSector(addr);
+    const uint8_t end = findSector(addr + size);
+    if (first >= MAX_SECTORS || end > MAX_SECTORS) return LX_ERROR;
+    return eraseSectors(first, end - first);
+}
+
+UINT Stm32F4FlashDriver::verifySectorErased(const uint32_t addr) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::verifySectorErased(0x%08x)\r\n",
+                     addr);
+
+    if (blockSize == 0 || addr % blockSize > 0 || addr >= getTotalSize()) return LX_ERROR;
+    const ULONG *word = getBaseAddress() + addr / sizeof(ULONG);
+    for (uint32_t i = 0; i < blockSize / sizeof(ULONG); i++) {
+        if (word[i] != 0xFFFFFFFF) return LX_ERROR;
+    }
+    return LX_SUCCESS;
+}
+
+UINT Stm32F4FlashDriver::initialize() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::initialize()\r\n");
+
+    blockSize = 0;
+    if (sectorCount == 0 || firstSector + sectorCount > MAX_SECTORS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::initialize() invalid sectors %u..%u\r\n",
+                         firstSector, firstSector + sectorCount - 1);
+        return LX_ERROR;
+    }
+
+#if defined(LIBSMART_STM32LEVELX_HAL_FLASH) && defined(FLASHSIZE_BASE)
+    const uint32_t flashSize = static_cast<uint32_t>(*reinterpret_cast<const uint16_t *>(FLASHSIZE_BASE)) * 1024;
+    if (getFlashSectorOffset(firstSector) + getTotalSize() > flashSize) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::initialize() sectors beyond %lu KB flash\r\n",
+                         flashSize / 1024);
+        return LX_ERROR;
+    }
+#endif
+
+    uint32_t size = 0;
+    for (uint8_t sector = firstSector; sector < firstSector + sectorCount; sector++) {
+        size = std::max(size, getFlashSectorSize(sector));
+    }
+
+    // Smaller sectors have to add up to the largest one
+    uint32_t filled = 0;
+    for (uint8_t sector = firstSector; sector < firstSector + sectorCount; sector++) {
+        filled += getFlashSectorSize(sector);
+        if (filled > size) break;
+        if (filled == size) filled = 0;
+    }
+    if (filled > 0) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::initialize() sectors %u..%u "
+                         "do not make %lu KB blocks\r\n",
+                         firstSector, firstSector + sectorCount - 1, size / 1024);
+        return LX_ERROR;
+    }
+
+    if (getTotalSize() / size < 2) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::initialize() LevelX needs 2 blocks or more\r\n");
+        return LX_ERROR;
+    }
+
+    blockSize = size;
+    return LX_SUCCESS;
+}
+
+UINT Stm32F4FlashDriver::reset() {
+    return LX_SUCCESS;
+}
+
+uint8_t Stm32F4FlashDriver::findSector(const uint32_t addr) const {
+    const uint32_t base = getFlashSectorOffset(firstSector);
+    for (uint8_t sector = firstSector; sector <= firstSector + sectorCount; sector++) {
+        if (getFlashSectorOffset(sector) - base == addr) return sector;
+    }
+    return MAX_SECTORS + 1;
+}
+
+UINT Stm32F4FlashDriver::eraseSectors(const uint8_t sector, const uint8_t count) {
+#ifdef LIBSMART_STM32LEVELX_HAL_FLASH
+    FLASH_EraseInitTypeDef erase = {};
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = sector;
+    erase.NbSectors = count;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    uint32_t sectorError = 0;
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+        FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    const auto ret = HAL_FLASHEx_Erase(&erase, &sectorError);
+    HAL_FLASH_Lock();
+
+    if (ret != HAL_OK) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::eraseSectors() sector %lu failed, 0x%08lx\r\n",
+                         sectorError, HAL_FLASH_GetError());
+        return LX_ERROR;
+    }
+#else
+    const uint32_t offset = getFlashSectorOffset(sector) - getFlashSectorOffset(firstSector);
+    const uint32_t size = getFlashSectorOffset(sector + count) - getFlashSectorOffset(sector);
+    std::memset(memory + offset, 0xFF, size);
+#endif
+    return LX_SUCCESS;
+}
+
+UINT Stm32F4FlashDriver::program(const uint32_t addr, const uint8_t *in, const size_t size) {
+#ifdef LIBSMART_STM32LEVELX_HAL_FLASH
+    const uint32_t base = FLASH_BASE + getFlashSectorOffset(firstSector);
+    auto ret = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+        FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    for (size_t offset = 0; offset < size && ret == HAL_OK;) {
+        const uint32_t address = base + addr + offset;
+        if (address % sizeof(uint32_t) == 0 && offset + sizeof(uint32_t) <= size) {
+            uint32_t word;
+            std::memcpy(&word, &in[offset], sizeof(word));
+            ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, word);
+            offset += sizeof(word);
+        } else {
+            ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address, in[offset]);
+            offset++;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (ret != HAL_OK) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::Stm32F4FlashDriver::program() failed, 0x%08lx\r\n",
+                         HAL_FLASH_GetError());
+        return LX_ERROR;
+    }
+#else
+    // Programming can only clear bits
+    for (size_t offset = 0; offset < size; offset++) memory[addr + offset] &= in[offset];
+#endif
+    return LX_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_STM32F4FLASHDRIVER_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_STM32F4FLASHDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "../AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+
+#if defined(HAL_FLASH_MODULE_ENABLED) && defined(FLASH_CR_SER) && !defined(LIBSMART_STM32LEVELX_SIMULATED_FLASH)
+#define LIBSMART_STM32LEVELX_HAL_FLASH
+#endif
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Driver for the sectors of the STM32F4 on-chip flash.
+     *
+     * The driver uses a range of consecutive flash sectors. The sectors of a bank are not uniform
+     * (4 x 16 KB, 1 x 64 KB, 7 x 128 KB), so the driver groups them into erase blocks of the size of the largest
+     * sector in the range: sectors 0 to 4 make two 64 KB blocks, sectors 0 to 3 and sector 4, for example.
+     * initialize() fails if the sectors cannot be grouped that way. The range must not overlap the sectors the firmware is linked to.
+     *
+     * The flash is memory mapped, so getBaseAddress() returns the address of the first sector, and LevelX reads
+     * the flash directly if LX_DIRECT_READ is defined. Words are programmed with 32 bit parallelism, which needs
+     * a supply voltage of 2.7 V to 3.6 V.
+     *
+     * While a sector is erased (up to 2 s for 128 KB), the CPU stalls on every fetch from the same bank.
+     *
+     * Without the HAL flash module, or with LIBSMART_STM32LEVELX_SIMULATED_FLASH defined, the driver works on
+     * a RAM image instead, which is programmed and erased like the flash. This allows to run it on a host.
+     */
+    class Stm32F4FlashDriver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
+    public:
+#ifdef LIBSMART_STM32LEVELX_HAL_FLASH
+        /**
+         * @param firstSector Number of the first flash sector, FLASH_SECTOR_0 to FLASH_SECTOR_23.
+         * @param sectorCount Number of sectors.
+         */
+        Stm32F4FlashDriver(const uint8_t firstSector, const uint8_t sectorCount)
+            : firstSector(firstSector), sectorCount(sectorCount) { ; }
+
+        Stm32F4FlashDriver(const uint8_t firstSector, const uint8_t sectorCount,
+                           Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              firstSector(firstSector), sectorCount(sectorCount) { ; }
+#else
+        /**
+         * @param firstSector Number of the first flash sector, 0 to 23.
+         * @param sectorCount Number of sectors.
+         * @param memory RAM image of the sectors, getTotalSize() bytes.
+         */
+        Stm32F4FlashDriver(const uint8_t firstSector, const uint8_t sectorCount, uint8_t *memory)
+            : firstSector(firstSector), sectorCount(sectorCount), memory(memory) { ; }
+
+        Stm32F4FlashDriver(const uint8_t firstSector, const uint8_t sectorCount, uint8_t *memory,
+                           Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              firstSector(firstSector), sectorCount(sectorCount), memory(memory) { ; }
+#endif
+
+        /**
+         * Flash sectors per bank.
+         */
+        static constexpr uint8_t SECTORS_PER_BANK = 12;
+
+        /**
+         * Sectors of the second bank of the 2 MByte devices.
+         */
+        static constexpr uint8_t MAX_SECTORS = 2 * SECTORS_PER_BANK;
+
+        static constexpr uint32_t BANK_SIZE = 1024 * 1024;
+
+        /**
+         * @brief Returns the size of a flash sector.
+         */
+        static constexpr uint32_t getFlashSectorSize(const uint8_t sector) {
+            const uint8_t n = sector % SECTORS_PER_BANK;
+            return n < 4 ? 16 * 1024 : n == 4 ? 64 * 1024 : 128 * 1024;
+        }
+
+        /**
+         * @brief Returns the offset of a flash sector from the start of the flash.
+         */
+        static constexpr uint32_t getFlashSectorOffset(const uint8_t sector) {
+            const uint8_t n = sector % SECTORS_PER_BANK;
+            const uint32_t offset = n < 4 ? n * 16 * 1024 : n == 4 ? 64 * 1024 : (n - 4) * 128 * 1024;
+            return sector / SECTORS_PER_BANK * BANK_SIZE + offset;
+        }
+
+        /**
+         * @brief Returns the size of all sectors of the range in bytes.
+         */
+        [[nodiscard]] uint32_t getTotalSize() const;
+
+        ULONG getTotalSectors() override;
+
+        /**
+         * @brief Returns the size of the largest flash sector in the range, which is the sector size for LevelX.
+         */
+        ULONG getSectorSize() override;
+
+        ULONG *getBaseAddress() override;
+
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+        /**
+         * @brief Programs the data word by word and compares it with the flash.
+         *
+         * @return LX_SUCCESS, LX_INVALID_WRITE if the flash does not hold the data afterwards, or LX_ERROR.
+         */
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
+
+        /**
+         * @brief Erases all flash sectors of the block at addr.
+         */
+        UINT eraseSector(uint32_t addr, ULONG erase_count) override;
+
+        /**
+         * @brief Erases all flash sectors of the range with one HAL_FLASHEx_Erase().
+         */
+        UINT eraseRange(uint32_t addr, uint32_t size) override;
+
+        UINT verifySectorErased(uint32_t addr) override;
+
+        /**
+         * @brief Checks the sector range and groups the sectors into blocks.
+         *
+         * @return LX_ERROR if the range is beyond the flash, the sectors do not fill the blocks evenly or there
+         *         are less than 2 blocks.
+         */
+        UINT initialize() override;
+
+        UINT reset() override;
+
+    protected:
+        /**
+         * @brief Returns the sector that starts at offset addr of the range.
+         *
+         * @return The sector after the range for the end of the range, MAX_SECTORS + 1 if no sector starts at addr.
+         */
+        [[nodiscard]] uint8_t findSector(uint32_t addr) const;
+
+        UINT eraseSectors(uint8_t sector, uint8_t count);
+
+        UINT program(uint32_t addr, const uint8_t *in, size_t size);
+
+        uint8_t firstSector;
+        uint8_t sectorCount;
+        uint32_t blockSize = 0;
+#ifndef LIBSMART_STM32LEVELX_HAL_FLASH
+        uint8_t *memory;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include "StripedNorDriver.hpp"
+
+using namespace Stm32LevelX::Driver;
+
+ULONG StripedNorDriver::getTotalSectors() {
+    return totalSectors;
+}
+
+ULONG StripedNorDriver::getSectorSize() {
+    return driverSectorSize * count;
+}
+
+UINT StripedNorDriver::read(const uint32_t addr, uint8_t *out, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::read(0x%08x, %p, %lu)\r\n",
+                     addr, &out, size);
+
+    if (driverSectorSize == 0) return LX_ERROR;
+
+    for (size_t offset = 0; offset < size;) {
+        uint8_t driver;
+        uint32_t driverAddr;
+        const size_t sz = std::min(static_cast<size_t>(map(addr + offset, driver, driverAddr)), size - offset);
+        const UINT ret = drivers[driver]->read(driverAddr, &out[offset], sz);
+        if (ret != LX_SUCCESS) return ret;
+        offset += sz;
+    }
+    return LX_SUCCESS;
+}
+
+UINT StripedNorDriver::write(const uint32_t addr, uint8_t *in, const size_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::write(0x%08x, %p, %lu)\r\n",
+                     addr, &in, size);
+
+    if (driverSectorSize == 0) return LX_ERROR;
+
+    for (size_t offset = 0; offset < size;) {
+        uint8_t driver;
+        uint32_t driverAddr;
+        const size_t sz = std::min(static_cast<size_t>(map(addr + offset, driver, driverAddr)), size - offset);
+        // The other devices keep programming while this one finishes its previous stripe
+        UINT ret = LX_SUCCESS;
+        if (pending[driver]) {
+            pending[driver] = false;
+            ret = drivers[driver]->finish();
+        }
+        ret = ret != LX_SUCCESS ? ret : drivers[driver]->startWrite(driverAddr, &in[offset], sz);
+        pending[driver] = ret == LX_SUCCESS;
+        if (ret != LX_SUCCESS) return finishAll(ret);
+        offset += sz;
+    }
+    return finishAll(LX_SUCCESS);
+}
+
+UINT StripedNorDriver::eraseSector(const uint32_t addr, const ULONG erase_count) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::eraseSector(0x%08x)\r\n",
+                     addr);
+
+    if (driverSectorSize == 0 || addr % getSectorSize() > 0) return LX_ERROR;
+    const uint32_t driverAddr = addr / count;
+    for (uint8_t driver = 0; driver < count; driver++) {
+        const UINT ret = drivers[driver]->startEraseSector(driverAddr, erase_count);
+        pending[driver] = ret == LX_SUCCESS;
+        if (ret != LX_SUCCESS) return finishAll(ret);
+    }
+    return finishAll(LX_SUCCESS);
+}
+
+UINT StripedNorDriver::eraseRange(const uint32_t addr, const uint32_t size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::eraseRange(0x%08x, %lu)\r\n",
+                     addr, size);
+
+    const ULONG sectorSize = getSectorSize();
+    if (sectorSize == 0 || addr % sectorSize > 0 || size % sectorSize > 0) return LX_ERROR;
+    for (uint8_t driver = 0; driver < count; driver++) {
+        const UINT ret = drivers[driver]->eraseRange(addr / count, size / count);
+        if (ret != LX_SUCCESS) return ret;
+    }
+    return LX_SUCCESS;
+}
+
+UINT StripedNorDriver::verifySectorErased(const uint32_t addr) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::verifySectorErased(0x%08x)\r\n",
+                     addr);
+
+    if (driverSectorSize == 0 || addr % getSectorSize() > 0) return LX_ERROR;
+    for (uint8_t driver = 0; driver < count; driver++) {
+        const UINT ret = drivers[driver]->verifySectorErased(addr / count);
+        if (ret != LX_SUCCESS) return ret;
+    }
+    return LX_SUCCESS;
+}
+
+UINT StripedNorDriver::initialize() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::Driver::StripedNorDriver::initialize()\r\n");
+
+    driverSectorSize = 0;
+    totalSectors = 0;
+    if (count == 0 || stripeSize == 0) return LX_ERROR;
+
+    ULONG sectorSize = 0;
+    ULONG sectors = 0;
+    for (uint8_t driver = 0; driver < count; driver++) {
+        pending[driver] = false;
+        const UINT ret = drivers[driver]->initialize();
+        if (ret != LX_SUCCESS) {
+            LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                    ->printf("Stm32LevelX::Driver::StripedNorDriver::initialize() driver %u failed\r\n", driver);
+            return ret;
+        }
+        if (driver == 0) {
+            sectorSize = drivers[driver]->getSectorSize();
+            sectors = drivers[driver]->getTotalSectors();
+        } else if (drivers[driver]->getSectorSize() != sectorSize) {
+            LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                    ->printf("Stm32LevelX::Driver::StripedNorDriver::initialize() driver %u sector size %lu\r\n",
+                             driver, drivers[driver]->getSectorSize());
+            return LX_ERROR;
+        }
+        sectors = std::min(sectors, drivers[driver]->getTotalSectors());
+    }
+    if (sectorSize % stripeSize > 0) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::Driver::StripedNorDriver::initialize() stripe size %u\r\n", stripeSize);
+        return LX_ERROR;
+    }
+
+    driverSectorSize = sectorSize;
+    totalSectors = sectors;
+    return LX_SUCCESS;
+}
+
+UINT StripedNorDriver::reset() {
+    UINT ret = LX_SUCCESS;
+    for (uint8_t driver = 0; driver < count; driver++) {
+        pending[driver] = false;
+        const UINT driverRet = drivers[driver]->reset();
+        ret = ret != LX_SUCCESS ? ret : driverRet;
+    }
+    return ret;
+}
+
+uint16_t StripedNorDriver::map(const uint32_t addr, uint8_t &driver, uint32_t &driverAddr) const {
+    const uint32_t sector = addr / (driverSectorSize * count);
+    const uint32_t offset = addr % (driverSectorSize * count);
+    const uint32_t stripe = offset / stripeSize;
+    driver = stripe % count;
+    driverAddr = sector * driverSectorSize + stripe / count * stripeSize + offset % stripeSize;
+    return stripeSize - offset % stripeSize;
+}
+
+UINT StripedNorDriver::finishAll(UINT ret) {
+    for (uint8_t driver = 0; driver < count; driver++) {
+        if (!pending[driver]) continue;
+        pending[driver] = false;
+        const UINT driverRet = drivers[driver]->finish();
+        ret = ret != LX_SUCCESS ? ret : driverRet;
+    }
+    return ret;
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_STRIPEDNORDRIVER_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_STRIPEDNORDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "../AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "../LogLevel.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Driver that stripes the flash over several devices of the same kind.
+     *
+     * A sector of this driver consists of the sectors with the same number on all devices, e.g. two SST26 on
+     * SPI1 and SPI2 give 8 KB sectors. Within a sector, the devices take turns every stripeSize bytes.
+     *
+     * A sector erase starts the erase on all devices before it waits for the first one, so the devices erase
+     * at the same time. Writes start programming a stripe on every device before they wait for the device
+     * they need next, see AbstractNorDriver::startWrite(). With the default stripe size of one SST26 page, a
+     * LevelX sector of 512 bytes is programmed on two devices at the same time.
+     *
+     * The devices are accessed from the calling thread, one after the other. Only the erase and program times
+     * overlap, so every device should be connected to its own SPI bus or at least have its own chip select.
+     */
+    class StripedNorDriver : public AbstractNorDriver, public Stm32ItmLogger::Loggable {
+    public:
+        static constexpr uint8_t MAX_DRIVERS = 4;
+
+        static constexpr uint16_t DEFAULT_STRIPE_SIZE = 256;
+
+        /**
+         * @param drivers Drivers of the devices, all with the same sector size.
+         * @param count Number of drivers, 1 to MAX_DRIVERS.
+         * @param stripeSize Bytes written to one device before the next one, must divide the sector size.
+         */
+        StripedNorDriver(AbstractNorDriver *const *drivers, const uint8_t count,
+                         const uint16_t stripeSize = DEFAULT_STRIPE_SIZE)
+            : count(count), stripeSize(stripeSize) { setDrivers(drivers); }
+
+        StripedNorDriver(AbstractNorDriver *const *drivers, const uint8_t count, const uint16_t stripeSize,
+                         Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger),
+              count(count), stripeSize(stripeSize) { setDrivers(drivers); }
+
+        [[nodiscard]] uint8_t getDriverCount() const { return count; }
+
+        [[nodiscard]] uint16_t getStripeSize() const { return stripeSize; }
+
+        /**
+         * @brief Returns the smallest number of sectors of all devices.
+         */
+        ULONG getTotalSectors() override;
+
+        /**
+         * @brief Returns the sector size of the devices times the number of devices.
+         */
+        ULONG getSectorSize() override;
+
+        UINT read(uint32_t addr, uint8_t *out, size_t size) override;
+
+        /**
+         * @brief Writes the stripes, programming up to one stripe per device at the same time.
+         */
+        UINT write(uint32_t addr, uint8_t *in, size_t size) override;
+
+        /**
+         * @brief Erases the sector on all devices at the same time.
+         */
+        UINT eraseSector(uint32_t addr, ULONG erase_count) override;
+
+        /**
+         * @brief Erases the range on one device after the other, using their eraseRange().
+         */
+        UINT eraseRange(uint32_t addr, uint32_t size) override;
+
+        UINT verifySectorErased(uint32_t addr) override;
+
+        /**
+         * @brief Initializes all devices and checks that their sectors have the same size.
+         *
+         * @return LX_ERROR if a device fails or the geometry does not match.
+         */
+        UINT initialize() override;
+
+        UINT reset() override;
+
+    protected:
+        void setDrivers(AbstractNorDriver *const *newDrivers) {
+            if (count > MAX_DRIVERS) count = MAX_DRIVERS;
+            for (uint8_t i = 0; i < count; i++) drivers[i] = newDrivers[i];
+        }
+
+        /**
+         * @brief Finds the device and the device address of addr.
+         *
+         * @return Bytes from addr to the end of the stripe.
+         */
+        uint16_t map(uint32_t addr, uint8_t &driver, uint32_t &driverAddr) const;
+
+        /**
+         * @brief Calls finish() of all devices with a pending operation.
+         *
+         * @return ret, or the first error of the devices if ret is LX_SUCCESS.
+         */
+        UINT finishAll(UINT ret);
+
+        AbstractNorDriver *drivers[MAX_DRIVERS] = {};
+        uint8_t count;
+        uint16_t stripeSize;
+        ULONG driverSectorSize = 0;
+        ULONG totalSectors = 0;
+        bool pending[MAX_DRIVERS] = {};
+    };
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_ABSTRACTSPITRANSPORT_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_ABSTRACTSPITRANSPORT_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "Stm32Common.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief Bus used by the SPI NOR flash drivers to talk to the device.
+     *
+     * A transaction starts with select(), followed by any number of transmit() and receive() calls, and ends
+     * with unselect().
+     */
+    class AbstractSpiTransport {
+    public:
+        /**
+         * @brief Called when an asynchronous transfer has finished.
+         *
+         * @param status Result of the transfer.
+         * @param context Pointer that was passed when the transfer was started.
+         * @note May be called from interrupt context.
+         */
+        using Callback = void (*)(Stm32Common::HalStatus status, void *context);
+
+        virtual ~AbstractSpiTransport() = default;
+
+        virtual Stm32Common::HalStatus select() = 0;
+
+        virtual Stm32Common::HalStatus unselect() = 0;
+
+        virtual Stm32Common::HalStatus transmit(uint8_t data) = 0;
+
+        virtual Stm32Common::HalStatus transmit(const uint8_t *data, uint16_t size) = 0;
+
+        /**
+         * @brief Transmits a 16 bit value, most significant byte first.
+         */
+        virtual Stm32Common::HalStatus transmit_be(uint16_t data) = 0;
+
+        /**
+         * @brief Transmits a 32 bit value, most significant byte first.
+         */
+        virtual Stm32Common::HalStatus transmit_be(uint32_t data) = 0;
+
+        virtual Stm32Common::HalStatus receive(uint8_t *data, uint16_t size) = 0;
+
+        /**
+         * @brief Gives the calling thread exclusive use of the device until unlock() is called.
+         *
+         * Drivers hold the lock across a sequence of transactions that must not be interleaved with the
+         * transactions of another thread. The lock may be taken several times by the same thread. The default
+         * implementation does nothing.
+         *
+         * receiveAsync() hands the lock over to the transfer, which releases it after the callback has returned.
+         */
+        virtual void lock() { ; }
+
+        virtual void unlock() { ; }
+
+        /**
+         * @brief Returns the SPI clock frequency in Hz, or 0 if it is not known.
+         */
+        [[nodiscard]] virtual uint32_t getClockHz() const { return 0; }
+
+        /**
+         * @brief Returns the number of data lanes the transport can drive (1, 2 or 4).
+         */
+        [[nodiscard]] virtual uint8_t getMaxLanes() const { return 1; }
+
+        /**
+         * @brief Sets the number of data lanes for the following transmit() and receive() calls.
+         *
+         * select() starts every transaction on a single lane.
+         *
+         * @return HAL_ERROR if the transport cannot drive that many lanes.
+         */
+        virtual Stm32Common::HalStatus setLanes(const uint8_t lanes) {
+            return lanes == 1 ? Stm32Common::HalStatus::HAL_OK : Stm32Common::HalStatus::HAL_ERROR;
+        }
+
+        /**
+         * @brief Receives data by DMA and blocks the calling thread until the transfer has finished.
+         *
+         * Other threads get the CPU while the transfer is running. Transports without DMA receive the data
+         * by polling.
+         */
+        virtual Stm32Common::HalStatus receiveDma(uint8_t *data, const uint16_t size) {
+            return receive(data, size);
+        }
+
+        /**
+         * @brief Starts receiving data and returns immediately.
+         *
+         * The caller must hold lock() exactly once. If the transfer has been started, the lock belongs to the
+         * transfer: the calling thread no longer owns it, and it is released after the callback has returned,
+         * possibly from an interrupt. Until then lock() blocks every thread, including the calling one, so no
+         * other transaction can assert a chip select while the data is clocked in. If the transfer could not be
+         * started, the caller still holds the lock.
+         *
+         * The chip select stays asserted until the caller unselects it, usually from the callback.
+         * Transports without DMA receive the data by polling and call the callback before returning.
+         *
+         * @return HAL_OK if the transfer has been started. The callback is only called in this case.
+         */
+        virtual Stm32Common::HalStatus receiveAsync(uint8_t *data, const uint16_t size,
+                                                    const Callback callback, void *context) {
+            const auto ret = receive(data, size);
+            callback(ret, context);
+            unlock();
+            return Stm32Common::HalStatus::HAL_OK;
+        }
+    };
+}
+
+#endif
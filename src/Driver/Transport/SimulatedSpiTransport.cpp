@@ -0,0 +1,419 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include "SimulatedSpiTransport.hpp"
+#include "../Sfdp.hpp"
+#include "../Sst26Driver.hpp"
+
+using namespace Stm32LevelX::Driver;
+using Stm32Common::HalStatus;
+using Instruction = Sst26Driver::Instruction;
+
+HalStatus SimulatedSpiTransport::select() {
+    if (selected) return HalStatus::HAL_ERROR;
+    selected = true;
+    lanes = 1;
+    headerLength = 0;
+    dataOffset = 0;
+    pageBytes = 0;
+    current = {};
+    counters.transactions++;
+    clock->advance(timing.csOverhead_ns);
+    return HalStatus::HAL_OK;
+}
+
+HalStatus SimulatedSpiTransport::unselect() {
+    if (!selected) return HalStatus::HAL_ERROR;
+    selected = false;
+    if (headerLength > 0) {
+        current.encodingError = !isEncodingValid();
+        if (current.encodingError) {
+            counters.encodingErrors++;
+        } else {
+            execute();
+        }
+        counters.opcodes[current.opcode]++;
+        history[historyCount % HISTORY_SIZE] = current;
+        historyCount++;
+    }
+    return HalStatus::HAL_OK;
+}
+
+HalStatus SimulatedSpiTransport::transmit(const uint8_t data) {
+    return transmit(&data, 1);
+}
+
+HalStatus SimulatedSpiTransport::transmit(const uint8_t *data, const uint16_t size) {
+    if (!selected) return HalStatus::HAL_ERROR;
+    clockBytes(size);
+    current.txBytes += size;
+
+    for (uint16_t i = 0; i < size; i++) {
+        if (headerLength == 0 || headerLength < getHeaderLength()) {
+            header[headerLength++] = data[i];
+            if (headerLength > 1) trackLanes(current.addressLanes, lanes);
+            if (headerLength == 1) {
+                current.opcode = data[i];
+                current.opcodeLanes = lanes;
+                if (isBusy() && data[i] != Instruction::RDSR && data[i] != Instruction::WRSU) {
+                    counters.busyViolations++;
+                }
+                if (data[i] == Instruction::READ && timing.spiClockHz > Sst26Driver::READ_MAX_CLOCK_HZ) {
+                    counters.clockViolations++;
+                }
+            }
+            if (headerLength == 4) current.address = getAddress();
+            continue;
+        }
+        // Data phase of a program or register write command
+        trackLanes(current.dataLanes, lanes);
+        pageBuffer[pageBytes % sizeof(pageBuffer)] = data[i];
+        pageBytes++;
+    }
+    return HalStatus::HAL_OK;
+}
+
+HalStatus SimulatedSpiTransport::transmit_be(const uint16_t data) {
+    const uint8_t buffer[2] = {static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)};
+    return transmit(buffer, sizeof(buffer));
+}
+
+HalStatus SimulatedSpiTransport::transmit_be(const uint32_t data) {
+    const uint8_t buffer[4] = {
+        static_cast<uint8_t>(data >> 24), static_cast<uint8_t>(data >> 16),
+        static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)
+    };
+    return transmit(buffer, sizeof(buffer));
+}
+
+HalStatus SimulatedSpiTransport::receive(uint8_t *data, const uint16_t size) {
+    if (!selected || headerLength == 0) return HalStatus::HAL_ERROR;
+    clockBytes(size);
+    current.rxBytes += size;
+    trackLanes(current.dataLanes, lanes);
+
+    const uint32_t addr = getAddress();
+    const bool valid = isEncodingValid();
+    for (uint16_t i = 0; i < size; i++, dataOffset++) {
+        switch (valid ? current.opcode : Instruction::NOP) {
+            case Instruction::READ:
+            case Instruction::READ_HS:
+            case Instruction::SDOR:
+            case Instruction::SDIOR:
+            case Instruction::SQOR:
+            case Instruction::SQIOR:
+                data[i] = memory[(addr + dataOffset) % memorySize];
+                break;
+            case Instruction::RDSR:
+                data[i] = (isBusy() ? 1 << 0 : 0) | (wel ? 1 << 1 : 0) | (eraseSuspended ? 1 << 2 : 0);
+                if (isBusy()) clock->advance(std::min(static_cast<uint64_t>(pollInterval_ns), busyUntil_ns - clock->now()));
+                break;
+            case Instruction::RDCR:
+                data[i] = configurationRegister;
+                break;
+            case Instruction::RDID: {
+                if (jedecId != nullptr) {
+                    data[i] = jedecId[dataOffset % 3];
+                    break;
+                }
+                // SST26VF016B, 032B or 064B, depending on the size of the memory
+                const uint8_t sst26Id[3] = {
+                    Sst26Driver::JEDECID::BYTE_0, Sst26Driver::JEDECID::BYTE_1,
+                    static_cast<uint8_t>(memorySize >= 8 * 1024 * 1024
+                                             ? Sst26Driver::JEDECID::DEVICE_ID_SST26VF064B
+                                             : memorySize >= 4 * 1024 * 1024
+                                                   ? Sst26Driver::JEDECID::DEVICE_ID_SST26VF032B
+                                                   : Sst26Driver::JEDECID::DEVICE_ID_SST26VF016B)
+                };
+                data[i] = sst26Id[dataOffset % sizeof(sst26Id)];
+                break;
+            }
+            case Instruction::SFDP:
+                data[i] = addr + dataOffset < sfdpSize ? sfdp[addr + dataOffset] : 0xFF;
+                break;
+            case Instruction::RBPR:
+                data[i] = 0x00;
+                break;
+            default:
+                data[i] = 0xFF;
+                break;
+        }
+    }
+    return HalStatus::HAL_OK;
+}
+
+HalStatus SimulatedSpiTransport::setLanes(const uint8_t newLanes) {
+    if (!selected || (newLanes != 1 && newLanes != 2 && newLanes != 4) || newLanes > maxLanes) {
+        return HalStatus::HAL_ERROR;
+    }
+    lanes = newLanes;
+    return HalStatus::HAL_OK;
+}
+
+HalStatus SimulatedSpiTransport::receiveDma(uint8_t *data, const uint16_t size) {
+    counters.dmaTransfers++;
+    current.dma = true;
+    return receive(data, size);
+}
+
+HalStatus SimulatedSpiTransport::receiveAsync(uint8_t *data, const uint16_t size, const Callback callback,
+                                              void *context) {
+    if (pendingCallback != nullptr) return HalStatus::HAL_BUSY;
+    const auto ret = receiveDma(data, size);
+    if (!deferAsync) {
+        callback(ret, context);
+        unlock();
+        return HalStatus::HAL_OK;
+    }
+    // The lock of the caller belongs to the transfer until completeAsync()
+    unlock();
+    pendingStatus = ret;
+    pendingContext = context;
+    pendingCallback = callback;
+    return HalStatus::HAL_OK;
+}
+
+bool SimulatedSpiTransport::completeAsync() {
+    if (pendingCallback == nullptr) return false;
+    const Callback callback = pendingCallback;
+    callback(pendingStatus, pendingContext);
+    // Releases the lock of the transfer
+    pendingCallback = nullptr;
+    return true;
+}
+
+const SimulatedSpiTransport::Transaction *SimulatedSpiTransport::getTransaction(const uint8_t age) const {
+    if (age >= HISTORY_SIZE || age >= historyCount) return nullptr;
+    return &history[(historyCount - 1 - age) % HISTORY_SIZE];
+}
+
+uint8_t SimulatedSpiTransport::getHeaderLength() const {
+    switch (header[0]) {
+        case Instruction::READ:
+        case Instruction::PP:
+        case Instruction::SQPP:
+        case Instruction::SE:
+        case Instruction::BE:
+        case Instruction::RSID:
+            return 4;
+        case Instruction::READ_HS:
+        case Instruction::SDOR:
+        case Instruction::SDIOR:
+        case Instruction::SQOR:
+        case Instruction::SFDP:
+            return 5;
+        case Instruction::SQIOR:
+            return 7;
+        default:
+            return 1;
+    }
+}
+
+bool SimulatedSpiTransport::isEncodingValid() const {
+    if (sqiMode) return current.opcode == Instruction::RSTQIO && current.opcodeLanes == 4;
+    // RSTQIO is ignored in SPI mode
+    if (current.opcode == Instruction::RSTQIO && current.opcodeLanes == 4) return current.addressLanes == 0;
+    if (current.opcodeLanes != 1) return false;
+
+    uint8_t addressLanes = 1;
+    uint8_t dataLanes = 1;
+    switch (current.opcode) {
+        case Instruction::SDOR:
+            dataLanes = 2;
+            break;
+        case Instruction::SDIOR:
+            addressLanes = 2;
+            dataLanes = 2;
+            break;
+        case Instruction::SQOR:
+            dataLanes = 4;
+            break;
+        case Instruction::SQIOR:
+        case Instruction::SQPP:
+            addressLanes = 4;
+            dataLanes = 4;
+            break;
+        default:
+            break;
+    }
+    // The quad instructions need SIO2 and SIO3, which are WP# and HOLD# unless IOC is set
+    if (dataLanes == 4 && (configurationRegister & 1 << 1) == 0) return false;
+    if (current.addressLanes != 0 && current.addressLanes != addressLanes) return false;
+    return current.dataLanes == 0 || current.dataLanes == dataLanes;
+}
+
+void SimulatedSpiTransport::trackLanes(uint8_t &phaseLanes, const uint8_t lanes) {
+    if (phaseLanes == 0) {
+        phaseLanes = lanes;
+    } else if (phaseLanes != lanes) {
+        phaseLanes = 0xFF;
+    }
+}
+
+void SimulatedSpiTransport::clockBytes(const uint32_t bytes) {
+    clock->advance(static_cast<uint64_t>(bytes) * 8 / lanes * 1000000000ULL / timing.spiClockHz);
+}
+
+void SimulatedSpiTransport::execute() {
+    const bool reset = resetEnabled;
+    resetEnabled = false;
+
+    switch (current.opcode) {
+        case Instruction::WREN:
+            if (!isBusy()) wel = true;
+            break;
+        case Instruction::WRDI:
+            wel = false;
+            break;
+        case Instruction::RSTEN:
+            resetEnabled = true;
+            break;
+        case Instruction::EQIO:
+            sqiMode = true;
+            break;
+        case Instruction::RSTQIO:
+            sqiMode = false;
+            break;
+        case Instruction::RST:
+            if (reset) {
+                wel = false;
+                configurationRegister = 0;
+            }
+            break;
+        case Instruction::WRSR:
+            if (!wel) {
+                counters.rejectedWrites++;
+                break;
+            }
+            if (pageBytes >= 2) configurationRegister = pageBuffer[1];
+            wel = false;
+            break;
+        case Instruction::ULBPR:
+            if (!wel) {
+                counters.rejectedWrites++;
+                break;
+            }
+            blocksProtected = false;
+            wel = false;
+            break;
+        case Instruction::PP:
+        case Instruction::SQPP:
+            program();
+            break;
+        case Instruction::WRSU:
+            // Only erases can be suspended in this simulation
+            if (isBusy() && eraseRunning && !eraseSuspended) {
+                eraseRemaining_ns = busyUntil_ns - clock->now();
+                busyUntil_ns = clock->now() + timing.tWS_ns;
+                eraseSuspended = true;
+            }
+            break;
+        case Instruction::WRRE:
+            if (eraseSuspended && !isBusy()) {
+                busyUntil_ns = clock->now() + eraseRemaining_ns;
+                eraseSuspended = false;
+            }
+            break;
+        case Instruction::SE:
+            erase(getAddress() & ~(SimulatedNorDriver::SECTOR_SIZE - 1), SimulatedNorDriver::SECTOR_SIZE,
+                  timing.tSE_ns);
+            break;
+        case Instruction::BE: {
+            const uint32_t blockSize = getBlockSize(getAddress());
+            erase(getAddress() & ~(blockSize - 1), blockSize, timing.tBE_ns);
+            break;
+        }
+        case Instruction::CE:
+            erase(0, memorySize, timing.tCE_ns);
+            break;
+        default:
+            break;
+    }
+}
+
+void SimulatedSpiTransport::program() {
+    if (isBusy()) return;
+    if (!wel || blocksProtected || headerLength < getHeaderLength()) {
+        counters.rejectedWrites++;
+        return;
+    }
+
+    // Only the last PAGE_SIZE bytes are programmed, wrapping around within the page
+    constexpr uint32_t PAGE_SIZE = SimulatedNorDriver::PAGE_SIZE;
+    const uint32_t addr = getAddress() % memorySize;
+    const uint32_t pageStart = addr & ~(PAGE_SIZE - 1);
+    const uint32_t count = std::min(pageBytes, PAGE_SIZE);
+    const uint32_t first = pageBytes - count;
+    for (uint32_t i = first; i < pageBytes; i++) {
+        const uint32_t target = pageStart + (addr - pageStart + i) % PAGE_SIZE;
+        memory[target] &= pageBuffer[i % PAGE_SIZE];
+    }
+    busyUntil_ns = clock->now() + timing.tPP_ns;
+    eraseRunning = false;
+    wel = false;
+}
+
+uint32_t SimulatedSpiTransport::getBlockSize(const uint32_t addr) const {
+    if (addr < 0x8000 || addr >= memorySize - 0x8000) return 0x2000;
+    if (addr < 0x10000 || addr >= memorySize - 0x10000) return 0x8000;
+    return 0x10000;
+}
+
+void SimulatedSpiTransport::buildSfdp() {
+    const auto put = [this](const uint32_t offset, const uint32_t value) {
+        for (uint8_t i = 0; i < 4; i++) defaultSfdp[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+    };
+    // SFDP header, revision 1.6, two parameter headers
+    put(0x00, Sfdp::SIGNATURE);
+    put(0x04, 0xFF010106);
+    // BFPT revision 1.6, 16 DWORDs at 0x30
+    put(0x08, 0x10010600);
+    put(0x0C, 0xFF000030);
+    // Sector map revision 1.0, 2 DWORDs at 0x70, the block map is not uniform
+    put(0x10, 0x02010081);
+    put(0x14, 0xFF000070);
+    put(0x70, 0xFFFFFFFF);
+    put(0x74, 0xFFFFFFFF);
+
+    constexpr uint32_t BFPT = 0x30;
+    // 4 KByte erase with 0x20, 1-1-2, 1-2-2, 1-4-4 and 1-1-4 fast reads, 3 byte addresses
+    put(BFPT + 0 * 4, 0xFFF120E5);
+    put(BFPT + 1 * 4, memorySize * 8 - 1);
+    // SQOR (8 dummy clocks), SQIOR (2 mode and 4 dummy clocks)
+    put(BFPT + 2 * 4, 0x6B08EB44);
+    // SDOR (8 dummy clocks), SDIOR (4 mode clocks)
+    put(BFPT + 3 * 4, 0xBB803B08);
+    put(BFPT + 4 * 4, 0xFFFFFFEE);
+    put(BFPT + 5 * 4, 0xFFFFFFFF);
+    put(BFPT + 6 * 4, 0xFFFFFFFF);
+    // Erase types 4 KByte (SE), 8, 32 and 64 KByte (BE)
+    put(BFPT + 7 * 4, 0xD80D200C);
+    put(BFPT + 8 * 4, 0xD810D80F);
+    put(BFPT + 9 * 4, 0x00000000);
+    // 256 byte pages
+    put(BFPT + 10 * 4, 0x00000081);
+    put(BFPT + 11 * 4, 0x00000000);
+    // Suspend with 0xB0, resume with 0x30
+    put(BFPT + 12 * 4, 0xB030B030);
+    // Status polling with RDSR bit 0
+    put(BFPT + 13 * 4, 0x00000004);
+    // QE is bit 1 of the second register (IOC of the configuration register), read with 0x35
+    put(BFPT + 14 * 4, 0x00500000);
+    put(BFPT + 15 * 4, 0x00000000);
+}
+
+void SimulatedSpiTransport::erase(const uint32_t addr, const uint32_t size, const uint32_t time_ns) {
+    if (isBusy()) return;
+    if (!wel || blocksProtected || eraseSuspended) {
+        counters.rejectedWrites++;
+        return;
+    }
+    if (addr < memorySize) std::memset(&memory[addr], 0xFF, std::min(size, memorySize - addr));
+    busyUntil_ns = clock->now() + time_ns;
+    eraseRunning = true;
+    wel = false;
+}
@@ -0,0 +1,253 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_SIMULATEDSPITRANSPORT_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_SIMULATEDSPITRANSPORT_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "AbstractSpiTransport.hpp"
+#include "../SimulatedNorDriver.hpp"
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief SPI transport with a simulated SST26VF016B behind it.
+     *
+     * The transport decodes the SPI commands the way the device does and applies them to a RAM image, so
+     * Sst26Driver can run on a host. Every byte on the bus is charged to a VirtualClock, commands are counted
+     * per opcode and the most recent transactions are kept for inspection.
+     *
+     * While a program or erase is running, every status register read that reports BUSY advances the clock by
+     * pollInterval_ns, but not beyond the end of the operation. This models the delay a driver waits between two
+     * polls.
+     *
+     * The transport checks on how many lanes the instruction, the address and the data of every command are
+     * sent. Commands with a wrong encoding are counted and not executed, reads return 0xFF. The simulation
+     * covers SPI mode. After EQIO only RSTQIO is accepted.
+     *
+     * Sector and block erases can be suspended with WRSU and resumed with WRRE. The remaining erase time is
+     * kept while the erase is suspended.
+     *
+     * Like the SST26, the device powers up with all blocks write protected, and ULBPR removes the protection.
+     * The block protection is not modelled per block.
+     */
+    class SimulatedSpiTransport : public AbstractSpiTransport {
+    public:
+        using Timing = SimulatedNorDriver::Timing;
+
+        /**
+         * @brief A finished transaction, as seen on the bus.
+         */
+        struct Transaction {
+            uint8_t opcode; ///< First byte after chip select
+            uint32_t address; ///< 24 bit address, if the command has one
+            uint32_t txBytes; ///< Bytes sent to the device, including the opcode
+            uint32_t rxBytes; ///< Bytes received from the device
+            bool dma; ///< Data phase used receiveDma() or receiveAsync()
+            uint8_t opcodeLanes; ///< Lanes the instruction was sent on
+            uint8_t addressLanes; ///< Lanes of address, mode and dummy bytes, 0 if none, 0xFF if mixed
+            uint8_t dataLanes; ///< Lanes of the data phase, 0 if none, 0xFF if mixed
+            bool encodingError; ///< The device could not decode the command
+        };
+
+        struct Counters {
+            uint32_t transactions; ///< Chip select toggles
+            uint32_t dmaTransfers; ///< Calls to receiveDma() and receiveAsync()
+            uint32_t busyViolations; ///< Commands other than RDSR issued while the device was busy
+            uint32_t clockViolations; ///< READ commands issued above Sst26Driver::READ_MAX_CLOCK_HZ
+            uint32_t encodingErrors; ///< Commands sent on the wrong lanes, quad commands without IOC, ...
+            uint32_t rejectedWrites; ///< Program or erase commands issued without WEL or to protected blocks
+            uint32_t opcodes[256]; ///< Transactions per opcode
+        };
+
+        static constexpr uint8_t HISTORY_SIZE = 16;
+
+        /**
+         * @param memory Memory that holds the simulated flash array.
+         * @param size Size of the memory in bytes.
+         * @param clock Clock to charge the bus and device times to.
+         */
+        SimulatedSpiTransport(uint8_t *memory, const uint32_t size, VirtualClock *clock)
+            : memory(memory), memorySize(size), clock(clock) { buildSfdp(); }
+
+        Stm32Common::HalStatus select() override;
+
+        Stm32Common::HalStatus unselect() override;
+
+        Stm32Common::HalStatus transmit(uint8_t data) override;
+
+        Stm32Common::HalStatus transmit(const uint8_t *data, uint16_t size) override;
+
+        Stm32Common::HalStatus transmit_be(uint16_t data) override;
+
+        Stm32Common::HalStatus transmit_be(uint32_t data) override;
+
+        Stm32Common::HalStatus receive(uint8_t *data, uint16_t size) override;
+
+        Stm32Common::HalStatus receiveDma(uint8_t *data, uint16_t size) override;
+
+        Stm32Common::HalStatus receiveAsync(uint8_t *data, uint16_t size, Callback callback, void *context) override;
+
+        /**
+         * @brief Counts the nesting depth. The simulation is single threaded, so the lock never blocks.
+         */
+        void lock() override { lockDepth++; }
+
+        void unlock() override { if (lockDepth > 0) lockDepth--; }
+
+        /**
+         * @brief Returns true while a thread or a deferred asynchronous transfer holds the lock.
+         */
+        [[nodiscard]] bool isLocked() const { return lockDepth > 0 || pendingCallback != nullptr; }
+
+        [[nodiscard]] uint32_t getClockHz() const override { return timing.spiClockHz; }
+
+        [[nodiscard]] uint8_t getMaxLanes() const override { return maxLanes; }
+
+        Stm32Common::HalStatus setLanes(uint8_t newLanes) override;
+
+        /**
+         * @brief Sets the number of data lanes the simulated bus provides (1, 2 or 4).
+         */
+        void setMaxLanes(const uint8_t lanes) { maxLanes = lanes; }
+
+        /**
+         * @brief Delivers the completion of a deferred asynchronous transfer.
+         *
+         * @return true if a callback has been called.
+         */
+        bool completeAsync();
+
+        /**
+         * @brief Defers the callback of receiveAsync() until completeAsync() is called.
+         */
+        void setDeferAsync(const bool defer) { deferAsync = defer; }
+
+        void setTiming(const Timing &newTiming) { timing = newTiming; }
+        void setPollInterval(const uint32_t ns) { pollInterval_ns = ns; }
+
+        /**
+         * @brief Sets the image returned by the SFDP command.
+         *
+         * By default the command returns a header and a BFPT like the ones of the SST26VF016B, with the density
+         * set to the size of the memory. The header also lists a sector map table, which is not filled in.
+         */
+        void setSfdp(const uint8_t *image, const uint16_t size) {
+            sfdp = image;
+            sfdpSize = size;
+        }
+
+        /**
+         * @brief Sets the 3 bytes returned by RDID. By default the device reports the SST26 of its size.
+         */
+        void setJedecId(const uint8_t *id) { jedecId = id; }
+
+        /**
+         * @brief Sets the write protection of all blocks, as after power-up.
+         */
+        void setBlocksProtected(const bool isProtected) { blocksProtected = isProtected; }
+
+        [[nodiscard]] bool isBlocksProtected() const { return blocksProtected; }
+
+        /**
+         * @brief Sets the whole array to 0xFF without charging any time.
+         */
+        void format() {
+            std::memset(memory, 0xFF, memorySize);
+            busyUntil_ns = 0;
+            eraseSuspended = false;
+        }
+
+        [[nodiscard]] const Counters &getCounters() const { return counters; }
+        void resetCounters() { counters = {}; }
+
+        [[nodiscard]] bool isBusy() const { return busyUntil_ns > clock->now(); }
+        [[nodiscard]] bool isWEL() const { return wel; }
+        [[nodiscard]] bool isSqiMode() const { return sqiMode; }
+        [[nodiscard]] bool isEraseSuspended() const { return eraseSuspended; }
+        [[nodiscard]] uint8_t getConfigurationRegister() const { return configurationRegister; }
+
+        /**
+         * @brief Returns a finished transaction.
+         *
+         * @param age 0 for the most recent transaction, 1 for the one before, ...
+         * @return nullptr if the history does not reach back that far.
+         */
+        [[nodiscard]] const Transaction *getTransaction(uint8_t age) const;
+
+    protected:
+        [[nodiscard]] uint8_t getHeaderLength() const;
+
+        /**
+         * @brief Checks the lanes of the current transaction against the definition of its instruction.
+         */
+        [[nodiscard]] bool isEncodingValid() const;
+
+        static void trackLanes(uint8_t &phaseLanes, uint8_t lanes);
+
+        [[nodiscard]] uint32_t getAddress() const {
+            return static_cast<uint32_t>(header[1]) << 16 | static_cast<uint32_t>(header[2]) << 8 | header[3];
+        }
+
+        void clockBytes(uint32_t bytes);
+
+        void execute();
+
+        void program();
+
+        /**
+         * @brief Returns the size of the block BE erases at the given address, following the SST26 block map.
+         */
+        [[nodiscard]] uint32_t getBlockSize(uint32_t addr) const;
+
+        void erase(uint32_t addr, uint32_t size, uint32_t time_ns);
+
+        void buildSfdp();
+
+        uint8_t *memory;
+        uint32_t memorySize;
+        VirtualClock *clock;
+        Timing timing = {};
+        uint32_t pollInterval_ns = 1000000;
+        uint8_t defaultSfdp[0x30 + 16 * 4 + 2 * 4] = {};
+        const uint8_t *sfdp = defaultSfdp;
+        uint16_t sfdpSize = sizeof(defaultSfdp);
+        const uint8_t *jedecId = nullptr;
+
+        uint8_t maxLanes = 1;
+
+        bool selected = false;
+        uint8_t lanes = 1;
+        bool wel = false;
+        bool blocksProtected = true;
+        bool resetEnabled = false;
+        bool sqiMode = false;
+        uint8_t configurationRegister = 0;
+        uint64_t busyUntil_ns = 0;
+        bool eraseRunning = false;
+        bool eraseSuspended = false;
+        uint64_t eraseRemaining_ns = 0;
+
+        uint8_t header[8] = {};
+        uint8_t headerLength = 0;
+        uint32_t dataOffset = 0;
+        uint8_t pageBuffer[SimulatedNorDriver::PAGE_SIZE] = {};
+        uint32_t pageBytes = 0;
+        Transaction current = {};
+
+        Counters counters = {};
+        Transaction history[HISTORY_SIZE] = {};
+        uint32_t historyCount = 0;
+
+        uint32_t lockDepth = 0;
+        bool deferAsync = false;
+        Callback pendingCallback = nullptr;
+        void *pendingContext = nullptr;
+        Stm32Common::HalStatus pendingStatus = Stm32Common::HalStatus::HAL_OK;
+    };
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Stm32SpiTransport.hpp"
+
+using namespace Stm32LevelX::Driver;
+using Stm32Common::HalStatus;
+
+Stm32SpiTransport::Stm32SpiTransport(Stm32Spi::Spi *spi, SPI_HandleTypeDef *hspi)
+    : spi(spi), hspi(hspi) {
+    if (hspi == nullptr) return;
+    for (auto &instance: instances) {
+        if (instance == nullptr) {
+            instance = this;
+            return;
+        }
+    }
+    // No free slot, fall back to polled transfers
+    this->hspi = nullptr;
+}
+
+Stm32SpiTransport::~Stm32SpiTransport() {
+    for (auto &instance: instances) {
+        if (instance == this) instance = nullptr;
+    }
+    if (dmaSemaphoreCreated) tx_semaphore_delete(&dmaSemaphore);
+    if (busSemaphoreCreated) tx_semaphore_delete(&busSemaphore);
+}
+
+UINT Stm32SpiTransport::setup() {
+    if (!busSemaphoreCreated) {
+        const auto ret = tx_semaphore_create(&busSemaphore, const_cast<CHAR *>("Stm32SpiTransport bus"), 1);
+        if (ret != TX_SUCCESS) return ret;
+        busSemaphoreCreated = true;
+    }
+    if (!dmaSemaphoreCreated) {
+        const auto ret = tx_semaphore_create(&dmaSemaphore, const_cast<CHAR *>("Stm32SpiTransport"), 0);
+        if (ret != TX_SUCCESS) return ret;
+        dmaSemaphoreCreated = true;
+    }
+    return TX_SUCCESS;
+}
+
+void Stm32SpiTransport::lock() {
+    TX_THREAD *thread = tx_thread_identify();
+    if (thread == TX_NULL || !busSemaphoreCreated) return;
+    if (busOwner == thread) {
+        busDepth++;
+        return;
+    }
+    tx_semaphore_get(&busSemaphore, TX_WAIT_FOREVER);
+    busOwner = thread;
+    busDepth = 1;
+}
+
+void Stm32SpiTransport::unlock() {
+    TX_THREAD *thread = tx_thread_identify();
+    if (thread == TX_NULL || !busSemaphoreCreated || busOwner != thread) return;
+    if (--busDepth > 0) return;
+    busOwner = nullptr;
+    tx_semaphore_put(&busSemaphore);
+}
+
+uint32_t Stm32SpiTransport::getClockHz() const {
+    if (hspi == nullptr) return 0;
+    // SPI1, SPI4, SPI5 and SPI6 are on APB2, all others on APB1
+    const uint32_t pclk = reinterpret_cast<uintptr_t>(hspi->Instance) >= APB2PERIPH_BASE
+                              ? HAL_RCC_GetPCLK2Freq()
+                              : HAL_RCC_GetPCLK1Freq();
+    const uint32_t prescaler = (hspi->Instance->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+    return pclk >> (prescaler + 1);
+}
+
+HalStatus Stm32SpiTransport::receiveDma(uint8_t *data, const uint16_t size) {
+    // Blocking on the semaphore is only possible from a thread
+    if (!isDmaEnabled() || !dmaSemaphoreCreated || tx_thread_identify() == TX_NULL) return receive(data, size);
+
+    const auto ret = static_cast<HalStatus>(HAL_SPI_Receive_DMA(hspi, data, size));
+    if (ret != HalStatus::HAL_OK) return ret;
+
+    constexpr ULONG timeout = (LIBSMART_STM32LEVELX_SPI_DMA_TIMEOUT_MS * TX_TIMER_TICKS_PER_SECOND + 999) / 1000;
+    if (tx_semaphore_get(&dmaSemaphore, timeout) != TX_SUCCESS) {
+        HAL_SPI_Abort(hspi);
+        return HalStatus::HAL_TIMEOUT;
+    }
+    return dmaStatus;
+}
+
+HalStatus Stm32SpiTransport::receiveAsync(uint8_t *data, const uint16_t size, const Callback callback, void *context) {
+    if (!isDmaEnabled()) return AbstractSpiTransport::receiveAsync(data, size, callback, context);
+    if (pendingCallback != nullptr) return HalStatus::HAL_BUSY;
+
+    // Hand the lock of the calling thread over to the transfer. complete() releases it.
+    TX_THREAD *thread = tx_thread_identify();
+    const bool handOver = thread != TX_NULL && busSemaphoreCreated;
+    if (handOver) {
+        if (busOwner != thread || busDepth != 1) return HalStatus::HAL_ERROR;
+        busOwner = nullptr;
+        busDepth = 0;
+        busHeldByTransfer = true;
+    }
+
+    pendingContext = context;
+    pendingCallback = callback;
+    const auto ret = static_cast<HalStatus>(HAL_SPI_Receive_DMA(hspi, data, size));
+    if (ret != HalStatus::HAL_OK) {
+        pendingCallback = nullptr;
+        if (handOver) {
+            busHeldByTransfer = false;
+            busOwner = thread;
+            busDepth = 1;
+        }
+    }
+    return ret;
+}
+
+void Stm32SpiTransport::onRxComplete(SPI_HandleTypeDef *hspi) {
+    const auto transport = findInstance(hspi);
+    if (transport != nullptr) transport->complete(HalStatus::HAL_OK);
+}
+
+void Stm32SpiTransport::onError(SPI_HandleTypeDef *hspi) {
+    const auto transport = findInstance(hspi);
+    if (transport != nullptr) transport->complete(HalStatus::HAL_ERROR);
+}
+
+Stm32SpiTransport *Stm32SpiTransport::findInstance(const SPI_HandleTypeDef *hspi) {
+    for (const auto instance: instances) {
+        if (instance != nullptr && instance->hspi == hspi) return instance;
+    }
+    return nullptr;
+}
+
+void Stm32SpiTransport::complete(const HalStatus status) {
+    if (pendingCallback != nullptr) {
+        const Callback callback = pendingCallback;
+        void *context = pendingContext;
+        pendingCallback = nullptr;
+        callback(status, context);
+        if (busHeldByTransfer) {
+            busHeldByTransfer = false;
+            tx_semaphore_put(&busSemaphore);
+        }
+        return;
+    }
+    dmaStatus = status;
+    if (dmaSemaphoreCreated) tx_semaphore_put(&dmaSemaphore);
+}
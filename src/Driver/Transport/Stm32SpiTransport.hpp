@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_STM32SPITRANSPORT_HPP
+#define LIBSMART_STM32LEVELX_DRIVER_TRANSPORT_STM32SPITRANSPORT_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "AbstractSpiTransport.hpp"
+#include "Stm32Spi.hpp"
+#include "tx_api.h"
+
+#ifndef LIBSMART_STM32LEVELX_SPI_DMA_TIMEOUT_MS
+#define LIBSMART_STM32LEVELX_SPI_DMA_TIMEOUT_MS 100
+#endif
+
+namespace Stm32LevelX::Driver {
+    /**
+     * @brief SPI transport on top of a Stm32Spi::Spi instance.
+     *
+     * Without a HAL handle all transfers are polled. With a HAL handle, receiveDma() and receiveAsync()
+     * use the DMA channels configured for the SPI peripheral, if there are any. In that case HAL_SPI_RxCpltCallback() and
+     * HAL_SPI_ErrorCallback() must forward to onRxComplete() and onError().
+     *
+     * setup() creates the ThreadX objects and must be called before the threads that share the transport start.
+     */
+    class Stm32SpiTransport : public AbstractSpiTransport {
+    public:
+        explicit Stm32SpiTransport(Stm32Spi::Spi *spi)
+            : Stm32SpiTransport(spi, nullptr) { ; }
+
+        /**
+         * @param spi SPI instance that handles chip select and polled transfers.
+         * @param hspi HAL handle of the same SPI peripheral, used for DMA transfers. nullptr disables DMA.
+         */
+        Stm32SpiTransport(Stm32Spi::Spi *spi, SPI_HandleTypeDef *hspi);
+
+        ~Stm32SpiTransport() override;
+
+        /**
+         * @brief Creates the bus semaphore and the DMA semaphore.
+         *
+         * Call it once from tx_application_define() or from a thread, before other threads use the transport.
+         * Until then lock() does nothing and receiveDma() polls.
+         *
+         * @return The error of tx_semaphore_create(), TX_SUCCESS if both exist.
+         */
+        UINT setup();
+
+        Stm32Common::HalStatus select() override { return spi->select(); }
+
+        Stm32Common::HalStatus unselect() override { return spi->unselect(); }
+
+        Stm32Common::HalStatus transmit(const uint8_t data) override { return spi->transmit(data); }
+
+        Stm32Common::HalStatus transmit(const uint8_t *data, const uint16_t size) override {
+            return spi->transmit(const_cast<uint8_t *>(data), size);
+        }
+
+        Stm32Common::HalStatus transmit_be(const uint16_t data) override { return spi->transmit_be(data); }
+
+        Stm32Common::HalStatus transmit_be(const uint32_t data) override { return spi->transmit_be(data); }
+
+        Stm32Common::HalStatus receive(uint8_t *data, const uint16_t size) override { return spi->receive(data, size); }
+
+        /**
+         * @brief Takes the bus semaphore. Does nothing outside of a thread or before setup().
+         *
+         * The bus lock is a binary semaphore rather than a mutex, because receiveAsync() releases it from the
+         * DMA interrupt. The owning thread and the nesting depth are tracked here, so the same thread can take
+         * the lock several times.
+         */
+        void lock() override;
+
+        void unlock() override;
+
+        /**
+         * @brief Returns the SPI clock, derived from the APB clock and the baud rate prescaler.
+         *
+         * @return 0 if no HAL handle has been given.
+         */
+        [[nodiscard]] uint32_t getClockHz() const override;
+
+        Stm32Common::HalStatus receiveDma(uint8_t *data, uint16_t size) override;
+
+        Stm32Common::HalStatus receiveAsync(uint8_t *data, uint16_t size, Callback callback, void *context) override;
+
+        /**
+         * @brief Returns true if the SPI peripheral has an RX and a TX DMA channel.
+         *
+         * In full duplex master mode, HAL_SPI_Receive_DMA() clocks the data with a transmit on the TX channel.
+         */
+        [[nodiscard]] bool isDmaEnabled() const {
+            return hspi != nullptr && hspi->hdmarx != nullptr && hspi->hdmatx != nullptr;
+        }
+
+        /**
+         * @brief Forward HAL_SPI_RxCpltCallback() to this method.
+         */
+        static void onRxComplete(SPI_HandleTypeDef *hspi);
+
+        /**
+         * @brief Forward HAL_SPI_ErrorCallback() to this method.
+         */
+        static void onError(SPI_HandleTypeDef *hspi);
+
+    protected:
+        static constexpr uint8_t MAX_INSTANCES = 4;
+        static Stm32SpiTransport *instances[MAX_INSTANCES];
+
+        static Stm32SpiTransport *findInstance(const SPI_HandleTypeDef *hspi);
+
+        void complete(Stm32Common::HalStatus status);
+
+        Stm32Spi::Spi *spi;
+        SPI_HandleTypeDef *hspi;
+        TX_SEMAPHORE dmaSemaphore = {};
+        bool dmaSemaphoreCreated = false;
+        TX_SEMAPHORE busSemaphore = {};
+        bool busSemaphoreCreated = false;
+        TX_THREAD *volatile busOwner = nullptr;
+        uint32_t busDepth = 0;
+        volatile bool busHeldByTransfer = false;
+        volatile Callback pendingCallback = nullptr;
+        void *volatile pendingContext = nullptr;
+        volatile Stm32Common::HalStatus dmaStatus = Stm32Common::HalStatus::HAL_OK;
+    };
+
+    inline Stm32SpiTransport *Stm32SpiTransport::instances[MAX_INSTANCES] = {};
+}
+
+#endif
@@ -3,21 +3,43 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <algorithm>
+
 #include "LevelXNorFlash.hpp"
+#ifndef LX_STANDALONE_ENABLE
+#include "Stm32LevelX.hpp"
+#endif
 
 using namespace Stm32LevelX;
 
+LevelXNorFlash::~LevelXNorFlash() {
+#ifndef LX_STANDALONE_ENABLE
+    // The threads use this instance until they return
+    stopPreEraseWorker();
+    stopDefragmentScheduler();
+#endif
+    // LevelX keeps open instances in a list
+    if (isOpen()) close();
+    detach();
+#ifndef LX_STANDALONE_ENABLE
+    // ThreadX keeps created mutexes in a list as well
+    if (mutexCreated) tx_mutex_delete(&mutex);
+    mutexCreated = false;
+#endif
+}
+
 LevelXErrorCode LevelXNorFlash::initialize() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->println("Stm32LevelX::LevelXNorFlash::initialize()");
 
     LX_initialized = false;
     LX_open = false;
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_initialize
-    auto ret = lx_nor_flash_initialize();
+    // It clears the list of open instances, which must stay intact while other instances are open
+    auto ret = _lx_nor_flash_opened_count == 0 ? lx_nor_flash_initialize() : LX_SUCCESS;
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_initialize() = 0x%02x\r\n", ret);
         return static_cast<LevelXErrorCode>(ret);
     }
@@ -27,19 +49,61 @@ LevelXErrorCode LevelXNorFlash::initialize() {
 
 
 LevelXErrorCode LevelXNorFlash::open() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->println("Stm32LevelX::LevelXNorFlash::open()");
 
     if (!isInitialized()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_open(): NOT INITIALIZED\r\n");
         return LevelXErrorCode::ERROR;
     }
 
+#ifdef LX_DIRECT_READ
+    // LevelX ignores the return value of driver_initialize() and would read the flash from address 0
+    if (driver->getBaseAddress() == nullptr) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_open(): LX_DIRECT_READ needs memory mapped flash\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+#endif
+
+#ifndef LX_STANDALONE_ENABLE
+    // sectorReadRange() and preErase() call into LevelX below lx_nor_flash_*(), so lock() must always serialize
+    if (createMutex() != TX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_open(): MUTEX NOT CREATED\r\n");
+        return LevelXErrorCode::SYSTEM_MUTEX_CREATE_FAILED;
+    }
+#endif
+
+    // driver_initialize() needs the slot for the driver callbacks, and LevelX would ignore its error
+    if (!attach()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_open(): MORE THAN %u INSTANCES OPEN\r\n", MAX_INSTANCES);
+        return LevelXErrorCode::ERROR;
+    }
+
+    // driver_initialize() passes the record to LevelX, which then skips the scan of the blocks
+    mountedFromCheckpoint = false;
+    mountRecordTaken = mountCheckpoint != nullptr && mountCheckpoint->take(mountRecord);
+
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_open
     auto ret = lx_nor_flash_open(this, const_cast<CHAR *>(getName()), driver_initialize);
+    mountRecordTaken = false;
+    if (ret == LX_SUCCESS && lx_nor_flash_mount_state_restored == LX_TRUE) {
+        // After a clean close, every physical sector is either free, mapped or obsolete
+        mountedFromCheckpoint = lx_nor_flash_free_physical_sectors + lx_nor_flash_mapped_physical_sectors +
+                                lx_nor_flash_obsolete_physical_sectors == lx_nor_flash_total_physical_sectors;
+        if (!mountedFromCheckpoint) {
+            LIBSMART_STM32LEVELX_LOG(log(), WARNING)
+                    ->printf("Stm32LevelX::LevelXNorFlash::open() checkpoint does not match, scanning\r\n");
+            lx_nor_flash_close(this);
+            ret = lx_nor_flash_open(this, const_cast<CHAR *>(getName()), driver_initialize);
+        }
+    }
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        detach();
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_open() = 0x%02x\r\n", ret);
         return static_cast<LevelXErrorCode>(ret);
     }
@@ -48,122 +112,702 @@ LevelXErrorCode LevelXNorFlash::open() {
 }
 
 LevelXErrorCode LevelXNorFlash::close() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->println("Stm32LevelX::LevelXNorFlash::close()");
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_close(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_close
+    lock();
+    MountCheckpoint::Record record = {};
+    record.totalBlocks = lx_nor_flash_total_blocks;
+    record.wordsPerBlock = lx_nor_flash_words_per_block;
+    record.freeSectors = lx_nor_flash_free_physical_sectors;
+    record.mappedSectors = lx_nor_flash_mapped_physical_sectors;
+    record.obsoleteSectors = lx_nor_flash_obsolete_physical_sectors;
+    record.minEraseCount = lx_nor_flash_minimum_erase_count;
+    record.maxEraseCount = lx_nor_flash_maximum_erase_count;
+    record.freeBlockSearch = lx_nor_flash_free_block_search;
     auto ret = lx_nor_flash_close(this);
+    // Inside the lock, so the pre-erase worker does not touch the closed flash
+    if (ret == LX_SUCCESS) LX_open = false;
+    unlock();
+    if (ret == LX_SUCCESS) detach();
+    if (ret == LX_SUCCESS && mountCheckpoint != nullptr && !mountCheckpoint->save(record)) {
+        LIBSMART_STM32LEVELX_LOG(log(), WARNING)
+                ->printf("Stm32LevelX::LevelXNorFlash::close() checkpoint not saved\r\n");
+    }
+#ifndef LX_STANDALONE_ENABLE
+    if (ret == LX_SUCCESS && extendedCacheMemory != nullptr) {
+        tx_byte_release(extendedCacheMemory);
+        extendedCacheMemory = nullptr;
+    }
+#endif
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_close() = 0x%02x\r\n", ret);
         return static_cast<LevelXErrorCode>(ret);
     }
-    LX_open = false;
+    return static_cast<LevelXErrorCode>(ret);
+}
+
+LevelXErrorCode LevelXNorFlash::format() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->println("Stm32LevelX::LevelXNorFlash::format()");
+
+    if (isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("format(): OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    driver->initialize();
+    auto ret = driver->eraseRange(0, driver->getTotalSectors() * driver->getSectorSize());
+    if (ret != LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("eraseRange() = 0x%02x\r\n", ret);
+    }
+    // The record of the last close() does not describe the erased flash
+    if (ret == LX_SUCCESS && mountCheckpoint != nullptr && !mountCheckpoint->invalidate()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::LevelXNorFlash::format() checkpoint not erased\r\n");
+        ret = LX_ERROR;
+    }
     return static_cast<LevelXErrorCode>(ret);
 }
 
 LevelXErrorCode LevelXNorFlash::defragment() {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->println("Stm32LevelX::LevelXNorFlash::defragment()");
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_defragment(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_defragment
+    lock();
+    // The scheduler of another thread calls this, close() may have won the lock
+    if (!isOpen()) {
+        unlock();
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_defragment(): CLOSED\r\n");
+        return LevelXErrorCode::ERROR;
+    }
     auto ret = lx_nor_flash_defragment(this);
+    unlock();
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_defragment() = 0x%02x\r\n", ret);
         return static_cast<LevelXErrorCode>(ret);
     }
-    LX_open = false;
+    // The flash stays open, the reclaim only moves sectors and erases blocks
     return static_cast<LevelXErrorCode>(ret);
 }
 
 LevelXErrorCode LevelXNorFlash::partialDefragment(const UINT max_blocks) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::LevelXNorFlash::partialDefragment(%d)\r\n", max_blocks);
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_partial_defragment(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_partial_defragment
+    lock();
+    if (!isOpen()) {
+        unlock();
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_partial_defragment(): CLOSED\r\n");
+        return LevelXErrorCode::ERROR;
+    }
     auto ret = lx_nor_flash_partial_defragment(this, max_blocks);
+    unlock();
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_partial_defragment() = 0x%02x\r\n", ret);
         return static_cast<LevelXErrorCode>(ret);
     }
-    LX_open = false;
     return static_cast<LevelXErrorCode>(ret);
 }
 
 LevelXErrorCode LevelXNorFlash::sectorRead(const ULONG logical_sector, void *buffer) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::LevelXNorFlash::sectorRead(%lu)\r\n", logical_sector);
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_read(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_sector_read
+    lock();
     auto ret = lx_nor_flash_sector_read(this, logical_sector, buffer);
+    unlock();
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_read() = 0x%02x\r\n", ret);
     }
     return static_cast<LevelXErrorCode>(ret);
 }
 
 LevelXErrorCode LevelXNorFlash::sectorRelease(const ULONG logical_sector) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::LevelXNorFlash::sectorRelease(%lu)\r\n", logical_sector);
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_release(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_sector_release
+    lock();
     auto ret = lx_nor_flash_sector_release(this, logical_sector);
+    unlock();
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_release() = 0x%02x\r\n", ret);
     }
     return static_cast<LevelXErrorCode>(ret);
 }
 
 LevelXErrorCode LevelXNorFlash::sectorWrite(const ULONG logical_sector, void *buffer) {
-    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
             ->printf("Stm32LevelX::LevelXNorFlash::sectorWrite(%lu)\r\n", logical_sector);
 
     if (!isOpen()) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_write(): NOT OPEN\r\n");
         return LevelXErrorCode::ERROR;
     }
 
     // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_sector_write
+    lock();
     auto ret = lx_nor_flash_sector_write(this, logical_sector, buffer);
+    unlock();
     if (ret != LX_SUCCESS) {
-        log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                 ->printf("lx_nor_flash_sector_write() = 0x%02x\r\n", ret);
     }
     return static_cast<LevelXErrorCode>(ret);
 }
 
+LevelXErrorCode LevelXNorFlash::sectorReadRange(const ULONG first_logical_sector, const ULONG count, void *buffer) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::sectorReadRange(%lu, %lu)\r\n", first_logical_sector, count);
+
+    if (!isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("sectorReadRange(): NOT OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    auto *out = static_cast<ULONG *>(buffer);
+    ULONG *runStart = nullptr;
+    ULONG *runBuffer = nullptr;
+    ULONG runSectors = 0;
+    UINT ret = LX_SUCCESS;
+
+    // Reads the physically consecutive sectors collected so far with one driver read
+    auto flush = [&]() -> UINT {
+        if (runSectors == 0) return LX_SUCCESS;
+        UINT status = _lx_nor_flash_driver_read(this, runStart, runBuffer, runSectors * LX_NOR_SECTOR_SIZE);
+        runSectors = 0;
+        if (status != LX_SUCCESS) {
+            _lx_nor_flash_system_error(this, status);
+            status = LX_ERROR;
+        }
+        return status;
+    };
+
+    // The lookups and reads bypass lx_nor_flash_sector_read(), so both mutexes it relies on are taken here
+    lock();
+#ifdef LX_THREAD_SAFE_ENABLE
+    tx_mutex_get(&lx_nor_flash_mutex, TX_WAIT_FOREVER);
+#endif
+    for (ULONG i = 0; i < count && ret == LX_SUCCESS; i++) {
+        ULONG *mapping_address;
+        ULONG *sector_address;
+        ULONG *sector_buffer = out + i * LX_NOR_SECTOR_SIZE;
+
+        // Same lookup as lx_nor_flash_sector_read()
+        _lx_nor_flash_logical_sector_find(this, first_logical_sector + i, LX_FALSE,
+                                          &mapping_address, &sector_address);
+
+        if (mapping_address == nullptr) {
+            // Never written, lx_nor_flash_sector_read() maps a free sector or fails
+            ret = flush();
+            if (ret == LX_SUCCESS) {
+                ret = lx_nor_flash_sector_read(this, first_logical_sector + i, sector_buffer);
+            }
+            continue;
+        }
+
+        lx_nor_flash_read_requests++;
+        if (runSectors > 0 && sector_address == runStart + runSectors * LX_NOR_SECTOR_SIZE) {
+            runSectors++;
+            continue;
+        }
+
+        ret = flush();
+        runStart = sector_address;
+        runBuffer = sector_buffer;
+        runSectors = 1;
+    }
+    if (ret == LX_SUCCESS) {
+        ret = flush();
+    }
+#ifdef LX_THREAD_SAFE_ENABLE
+    tx_mutex_put(&lx_nor_flash_mutex);
+#endif
+    unlock();
+
+    if (ret != LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("sectorReadRange() = 0x%02x\r\n", ret);
+    }
+    return static_cast<LevelXErrorCode>(ret);
+}
+
+LevelXErrorCode LevelXNorFlash::sectorWriteRange(const ULONG first_logical_sector, const ULONG count, void *buffer) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::sectorWriteRange(%lu, %lu)\r\n", first_logical_sector, count);
+
+    if (!isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("sectorWriteRange(): NOT OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    auto *in = static_cast<ULONG *>(buffer);
+    UINT ret = LX_SUCCESS;
+
+    // Every sector still needs its own mapping entry, which LevelX writes after the data to stay power fail safe
+    lock();
+    for (ULONG i = 0; i < count && ret == LX_SUCCESS; i++) {
+        ret = lx_nor_flash_sector_write(this, first_logical_sector + i, in + i * LX_NOR_SECTOR_SIZE);
+    }
+    unlock();
+
+    if (ret != LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("sectorWriteRange() = 0x%02x\r\n", ret);
+    }
+    return static_cast<LevelXErrorCode>(ret);
+}
+
+
+LevelXErrorCode LevelXNorFlash::enableExtendedCache(VOID *memory, const ULONG size) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::enableExtendedCache(%p, %lu)\r\n", memory, size);
+
+    if (!isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_extended_cache_enable(): NOT OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    // @see https://github.com/eclipse-threadx/rtos-docs/blob/main/rtos-docs/levelx/chapter6.md#lx_nor_flash_extended_cache_enable
+    lock();
+    auto ret = lx_nor_flash_extended_cache_enable(this, memory, size);
+    unlock();
+    if (ret != LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("lx_nor_flash_extended_cache_enable() = 0x%02x\r\n", ret);
+    }
+    return static_cast<LevelXErrorCode>(ret);
+}
+
+#ifndef LX_STANDALONE_ENABLE
+LevelXErrorCode LevelXNorFlash::enableExtendedCache(ULONG bytes) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::enableExtendedCache(%lu)\r\n", bytes);
+
+    // LevelX does not use more than LX_NOR_EXTENDED_CACHE_SIZE whole sectors
+    bytes = std::min<ULONG>(bytes, LX_NOR_EXTENDED_CACHE_SIZE * getSectorSize());
+    bytes -= bytes % getSectorSize();
+
+    VOID *memory = nullptr;
+    if (bytes > 0) {
+        if (LevelX::getBytePool() == nullptr ||
+            tx_byte_allocate(LevelX::getBytePool(), &memory, bytes, TX_NO_WAIT) != TX_SUCCESS) {
+            LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                    ->printf("enableExtendedCache(): no memory for %lu bytes\r\n", bytes);
+            return LevelXErrorCode::NO_MEMORY;
+        }
+    }
+
+    const auto ret = enableExtendedCache(memory, bytes);
+    if (ret != LevelXErrorCode::SUCCESS) {
+        if (memory != nullptr) tx_byte_release(memory);
+        return ret;
+    }
+    if (extendedCacheMemory != nullptr) tx_byte_release(extendedCacheMemory);
+    extendedCacheMemory = memory;
+    return ret;
+}
+#endif
+
+ULONG LevelXNorFlash::getExtendedCacheHits() const {
+#ifndef LX_NOR_DISABLE_EXTENDED_CACHE
+    return lx_nor_flash_extended_cache_hits;
+#else
+    return 0;
+#endif
+}
+
+ULONG LevelXNorFlash::getExtendedCacheMisses() const {
+#ifndef LX_NOR_DISABLE_EXTENDED_CACHE
+    return lx_nor_flash_extended_cache_misses;
+#else
+    return 0;
+#endif
+}
+
+void LevelXNorFlash::resetExtendedCacheCounters() {
+#ifndef LX_NOR_DISABLE_EXTENDED_CACHE
+    lx_nor_flash_extended_cache_hits = 0;
+    lx_nor_flash_extended_cache_misses = 0;
+#endif
+}
+
+LevelXErrorCode LevelXNorFlash::setDirectMapping(ULONG *memory, const ULONG entries) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::setDirectMapping(%p, %lu)\r\n", memory, entries);
+
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+    if (isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("setDirectMapping(): OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    directMapping = memory;
+    directMappingEntries = memory == nullptr ? 0 : entries;
+    return LevelXErrorCode::SUCCESS;
+#else
+    return LevelXErrorCode::DISABLED;
+#endif
+}
+
+LevelXErrorCode LevelXNorFlash::setFreeBitMapCache(ULONG *memory, const ULONG words) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::setFreeBitMapCache(%p, %lu)\r\n", memory, words);
+
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+    if (isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("setFreeBitMapCache(): OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    freeBitMapCache = memory;
+    freeBitMapCacheWords = memory == nullptr ? 0 : words;
+    return LevelXErrorCode::SUCCESS;
+#else
+    return LevelXErrorCode::DISABLED;
+#endif
+}
+
+LevelXNorFlash::Statistics LevelXNorFlash::getStatistics() const {
+    Statistics statistics = {};
+    if (!isOpen()) return statistics;
+
+    statistics.totalBlocks = lx_nor_flash_total_blocks;
+    statistics.sectorsPerBlock = lx_nor_flash_physical_sectors_per_block;
+    statistics.freeSectors = lx_nor_flash_free_physical_sectors;
+    statistics.mappedSectors = lx_nor_flash_mapped_physical_sectors;
+    statistics.obsoleteSectors = lx_nor_flash_obsolete_physical_sectors;
+    statistics.minEraseCount = lx_nor_flash_minimum_erase_count;
+    statistics.maxEraseCount = lx_nor_flash_maximum_erase_count;
+
+    statistics.readRequests = lx_nor_flash_read_requests;
+    statistics.writeRequests = lx_nor_flash_write_requests;
+    statistics.sectorAllocations = lx_nor_flash_physical_block_allocates;
+    statistics.sectorAllocationErrors = lx_nor_flash_physical_block_allocate_errors;
+    statistics.mappingCacheHits = lx_nor_flash_sector_mapping_cache_hits;
+    statistics.mappingCacheMisses = lx_nor_flash_sector_mapping_cache_misses;
+    statistics.extendedCacheHits = getExtendedCacheHits();
+    statistics.extendedCacheMisses = getExtendedCacheMisses();
+    statistics.blockErases = blockErases;
+    statistics.wordsWritten = wordsWritten;
+    statistics.systemErrors = lx_nor_flash_diagnostic_system_errors;
+    statistics.lastSystemError = lx_nor_flash_diagnostic_system_error;
+
+    statistics.initialFormat = lx_nor_flash_diagnostic_initial_format;
+    statistics.openErasedBlocks = lx_nor_flash_diagnostic_erased_block;
+    statistics.openReErasedBlocks = lx_nor_flash_diagnostic_re_erase_block;
+    statistics.openSectorsObsoleted = lx_nor_flash_diagnostic_sector_being_obsoleted +
+                                      lx_nor_flash_diagnostic_sector_obsoleted;
+    statistics.openMappingsInvalidated = lx_nor_flash_diagnostic_mapping_invalidated;
+    statistics.openMappingWritesInterrupted = lx_nor_flash_diagnostic_mapping_write_interrupted;
+    statistics.openSectorsNotFree = lx_nor_flash_diagnostic_sector_not_free;
+    statistics.openSectorDataNotFree = lx_nor_flash_diagnostic_sector_data_not_free;
+    return statistics;
+}
+
+void LevelXNorFlash::resetStatistics() {
+    lock();
+    lx_nor_flash_read_requests = 0;
+    lx_nor_flash_write_requests = 0;
+    lx_nor_flash_physical_block_allocates = 0;
+    lx_nor_flash_physical_block_allocate_errors = 0;
+    lx_nor_flash_sector_mapping_cache_hits = 0;
+    lx_nor_flash_sector_mapping_cache_misses = 0;
+    lx_nor_flash_diagnostic_system_errors = 0;
+    lx_nor_flash_diagnostic_system_error = 0;
+    resetExtendedCacheCounters();
+    blockErases = 0;
+    wordsWritten = 0;
+    unlock();
+}
+
+bool LevelXNorFlash::needsPreErase(const ULONG freeBlocks) const {
+    if (!isOpen()) return false;
+    return lx_nor_flash_obsolete_physical_sectors > 0 &&
+           lx_nor_flash_free_physical_sectors <= (freeBlocks + 1) * lx_nor_flash_physical_sectors_per_block;
+}
+
+LevelXErrorCode LevelXNorFlash::preErase(const ULONG freeBlocks) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::preErase(%lu)\r\n", freeBlocks);
+
+    if (!isOpen()) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("preErase(): NOT OPEN\r\n");
+        return LevelXErrorCode::ERROR;
+    }
+
+    lock();
+    auto ret = LevelXErrorCode::NO_SECTORS;
+    if (needsPreErase(freeBlocks)) {
+        const ULONG freeSectors = lx_nor_flash_free_physical_sectors;
+        // The same as lx_nor_flash_sector_write() does when it runs out of free sectors, with the mutex of LevelX
+#ifdef LX_THREAD_SAFE_ENABLE
+        tx_mutex_get(&lx_nor_flash_mutex, TX_WAIT_FOREVER);
+#endif
+        const auto status = _lx_nor_flash_block_reclaim(this);
+#ifdef LX_THREAD_SAFE_ENABLE
+        tx_mutex_put(&lx_nor_flash_mutex);
+#endif
+        if (status != LX_SUCCESS) {
+            LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                    ->printf("_lx_nor_flash_block_reclaim() = 0x%02x\r\n", status);
+            ret = static_cast<LevelXErrorCode>(status);
+        } else if (lx_nor_flash_free_physical_sectors > freeSectors) {
+            ret = LevelXErrorCode::SUCCESS;
+        }
+    }
+    unlock();
+    return ret;
+}
+
+bool LevelXNorFlash::needsDefragment(const UINT obsoletePercent) const {
+    if (!isOpen()) return false;
+    return lx_nor_flash_obsolete_physical_sectors > 0 &&
+           lx_nor_flash_obsolete_physical_sectors * 100 >= obsoletePercent * lx_nor_flash_total_physical_sectors;
+}
+
+void LevelXNorFlash::restoreMountState() {
+    if (!mountRecordTaken) return;
+    mountRecordTaken = false;
+
+    if (mountRecord.totalBlocks != lx_nor_flash_total_blocks ||
+        mountRecord.wordsPerBlock != lx_nor_flash_words_per_block ||
+        mountRecord.freeBlockSearch >= lx_nor_flash_total_blocks ||
+        mountRecord.minEraseCount > mountRecord.maxEraseCount) {
+        LIBSMART_STM32LEVELX_LOG(log(), WARNING)
+                ->printf("Stm32LevelX::LevelXNorFlash::restoreMountState() checkpoint of another geometry\r\n");
+        return;
+    }
+
+    lx_nor_flash_free_physical_sectors = mountRecord.freeSectors;
+    lx_nor_flash_mapped_physical_sectors = mountRecord.mappedSectors;
+    lx_nor_flash_obsolete_physical_sectors = mountRecord.obsoleteSectors;
+    lx_nor_flash_minimum_erase_count = mountRecord.minEraseCount;
+    lx_nor_flash_maximum_erase_count = mountRecord.maxEraseCount;
+    lx_nor_flash_free_block_search = mountRecord.freeBlockSearch;
+    lx_nor_flash_mount_state_restored = LX_TRUE;
+}
+
+bool LevelXNorFlash::attach() {
+    if (slot < MAX_INSTANCES) return true;
+    for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+        if (instances[i] == nullptr) {
+            instances[i] = this;
+            slot = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LevelXNorFlash::detach() {
+    if (slot >= MAX_INSTANCES) return;
+    instances[slot] = nullptr;
+    slot = MAX_INSTANCES;
+}
+
+#ifdef LX_STANDALONE_ENABLE
+void LevelXNorFlash::lock() {
+}
+
+void LevelXNorFlash::unlock() {
+}
+#else
+void LevelXNorFlash::lock() {
+    if (!isWorker()) lastForegroundTime = tx_time_get();
+    if (!mutexCreated || tx_thread_identify() == TX_NULL) return;
+    tx_mutex_get(&mutex, TX_WAIT_FOREVER);
+}
+
+void LevelXNorFlash::unlock() {
+    if (!mutexCreated || tx_thread_identify() == TX_NULL) return;
+    tx_mutex_put(&mutex);
+}
+
+UINT LevelXNorFlash::startPreEraseWorker(TX_BYTE_POOL *byte_pool, const ULONG freeBlocks, const UINT priority) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::startPreEraseWorker(%p, %lu, %u)\r\n",
+                     byte_pool, freeBlocks, priority);
+
+    if (isPreEraseWorkerRunning()) return TX_THREAD_ERROR;
+
+    preEraseFreeBlocks = freeBlocks;
+    preEraseStop = false;
+    return startWorker(&preEraseThreadStruct, preEraseStack, "LevelXNorFlash::preErase", preEraseThread,
+                       byte_pool, LIBSMART_STM32LEVELX_PRE_ERASE_STACK_SIZE, priority);
+}
+
+UINT LevelXNorFlash::stopPreEraseWorker() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::stopPreEraseWorker()\r\n");
+
+    return stopWorker(&preEraseThreadStruct, preEraseStack, preEraseStop);
+}
+
+UINT LevelXNorFlash::startDefragmentScheduler(TX_BYTE_POOL *byte_pool, const DefragmentPolicy &policy,
+                                              const UINT priority) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::startDefragmentScheduler(%p, %u%%, %lu ms, %u, %u)\r\n",
+                     byte_pool, policy.obsoletePercent, policy.idleMs, policy.blocksPerStep, priority);
+
+    if (isDefragmentSchedulerRunning()) return TX_THREAD_ERROR;
+
+    defragmentPolicy = policy;
+    defragmentPolicy.blocksPerStep = std::max(policy.blocksPerStep, static_cast<UINT>(1));
+    defragmentStop = false;
+    return startWorker(&defragmentThreadStruct, defragmentStack, "LevelXNorFlash::defragment", defragmentThread,
+                       byte_pool, LIBSMART_STM32LEVELX_DEFRAGMENT_STACK_SIZE, priority);
+}
+
+UINT LevelXNorFlash::stopDefragmentScheduler() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::LevelXNorFlash::stopDefragmentScheduler()\r\n");
+
+    return stopWorker(&defragmentThreadStruct, defragmentStack, defragmentStop);
+}
+
+UINT LevelXNorFlash::createMutex() {
+    if (mutexCreated) return TX_SUCCESS;
+    const auto ret = tx_mutex_create(&mutex, const_cast<CHAR *>("LevelXNorFlash"), TX_INHERIT);
+    if (ret == TX_SUCCESS) mutexCreated = true;
+    return ret;
+}
+
+UINT LevelXNorFlash::startWorker(TX_THREAD *thread, UCHAR *&stack, const char *name, VOID (*entry)(ULONG),
+                                 TX_BYTE_POOL *byte_pool, const ULONG stackSize, const UINT priority) {
+    auto ret = createMutex();
+    if (ret != TX_SUCCESS) return ret;
+
+    ret = tx_byte_allocate(byte_pool, reinterpret_cast<VOID **>(&stack), stackSize, TX_NO_WAIT);
+    if (ret != TX_SUCCESS) {
+        stack = nullptr;
+        return ret;
+    }
+
+    ret = tx_thread_create(thread, const_cast<CHAR *>(name), entry,
+                           static_cast<ULONG>(reinterpret_cast<uintptr_t>(this)),
+                           stack, stackSize, priority, priority, TX_NO_TIME_SLICE, TX_AUTO_START);
+    if (ret != TX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("tx_thread_create() = 0x%02x\r\n", ret);
+        tx_byte_release(stack);
+        stack = nullptr;
+    }
+    return ret;
+}
+
+UINT LevelXNorFlash::stopWorker(TX_THREAD *thread, UCHAR *&stack, volatile bool &stop) {
+    if (stack == nullptr) return TX_SUCCESS;
+
+    // Let the thread finish its block, so it does not hold the mutex
+    stop = true;
+    UINT state = TX_READY;
+    while (tx_thread_info_get(thread, nullptr, &state, nullptr, nullptr, nullptr, nullptr,
+                              nullptr, nullptr) == TX_SUCCESS && state != TX_COMPLETED) {
+        tx_thread_sleep(1);
+    }
+
+    const auto ret = tx_thread_delete(thread);
+    if (ret != TX_SUCCESS) return ret;
+    tx_byte_release(stack);
+    stack = nullptr;
+    return TX_SUCCESS;
+}
+
+bool LevelXNorFlash::isWorker() const {
+    const TX_THREAD *current = tx_thread_identify();
+    return (current == &preEraseThreadStruct && preEraseStack != nullptr) ||
+           (current == &defragmentThreadStruct && defragmentStack != nullptr);
+}
+
+VOID LevelXNorFlash::preEraseThread(const ULONG input) {
+    auto *lx = reinterpret_cast<LevelXNorFlash *>(static_cast<uintptr_t>(input));
+    constexpr ULONG interval = (LIBSMART_STM32LEVELX_PRE_ERASE_INTERVAL_MS * TX_TIMER_TICKS_PER_SECOND + 999) / 1000;
+
+    while (!lx->preEraseStop) {
+        // Reclaim one block after the other while there is progress, then wait for the next writes
+        if (lx->needsPreErase(lx->preEraseFreeBlocks) &&
+            lx->preErase(lx->preEraseFreeBlocks) == LevelXErrorCode::SUCCESS) {
+            tx_thread_relinquish();
+            continue;
+        }
+        tx_thread_sleep(interval);
+    }
+}
+
+VOID LevelXNorFlash::defragmentThread(const ULONG input) {
+    auto *lx = reinterpret_cast<LevelXNorFlash *>(static_cast<uintptr_t>(input));
+    constexpr ULONG interval = (LIBSMART_STM32LEVELX_DEFRAGMENT_INTERVAL_MS * TX_TIMER_TICKS_PER_SECOND + 999) / 1000;
+    const auto idle = static_cast<ULONG>(
+        (static_cast<uint64_t>(lx->defragmentPolicy.idleMs) * TX_TIMER_TICKS_PER_SECOND + 999) / 1000);
+
+    while (!lx->defragmentStop) {
+        tx_thread_sleep(interval);
+
+        const ULONG lastForeground = lx->lastForegroundTime;
+        if (tx_time_get() - lastForeground < idle) continue;
+
+        // Step by step, until the threshold is reached or another thread wants the flash
+        while (!lx->defragmentStop && lx->lastForegroundTime == lastForeground &&
+               lx->needsDefragment(lx->defragmentPolicy.obsoletePercent)) {
+            const ULONG obsoleteSectors = lx->lx_nor_flash_obsolete_physical_sectors;
+            if (lx->partialDefragment(lx->defragmentPolicy.blocksPerStep) != LevelXErrorCode::SUCCESS ||
+                lx->lx_nor_flash_obsolete_physical_sectors >= obsoleteSectors) {
+                break;
+            }
+            tx_thread_relinquish();
+        }
+    }
+}
+#endif
@@ -10,18 +10,32 @@
 #include <main.h>
 
 #include <AbstractNorDriver.hpp>
-#include <Driver/Sst26Driver.hpp>
 
 #include "Loggable.hpp"
+#include "LogLevel.hpp"
 #include "lx_api.h"
+#include "MountCheckpoint.hpp"
 #include "Nameable.hpp"
 
 // #define LX_NOR_SECTOR_SIZE 4096
 
-namespace Stm32LevelX {
-    static ULONG nor_sector_memory[LX_NOR_SECTOR_SIZE];
+#ifndef LIBSMART_STM32LEVELX_PRE_ERASE_INTERVAL_MS
+#define LIBSMART_STM32LEVELX_PRE_ERASE_INTERVAL_MS 100
+#endif
+
+#ifndef LIBSMART_STM32LEVELX_PRE_ERASE_STACK_SIZE
+#define LIBSMART_STM32LEVELX_PRE_ERASE_STACK_SIZE 1024
+#endif
+
+#ifndef LIBSMART_STM32LEVELX_DEFRAGMENT_INTERVAL_MS
+#define LIBSMART_STM32LEVELX_DEFRAGMENT_INTERVAL_MS 100
+#endif
 
+#ifndef LIBSMART_STM32LEVELX_DEFRAGMENT_STACK_SIZE
+#define LIBSMART_STM32LEVELX_DEFRAGMENT_STACK_SIZE 1024
+#endif
 
+namespace Stm32LevelX {
     enum class LevelXErrorCode : UINT {
         SUCCESS = 0x00,
         ERROR = 0x01,
@@ -43,18 +57,66 @@ namespace Stm32LevelX {
     class LevelXNorFlash : public Stm32ItmLogger::Loggable, public Stm32Common::Nameable, public LX_NOR_FLASH {
     public:
         explicit LevelXNorFlash(AbstractNorDriver *driver)
-            : LX_NOR_FLASH_STRUCT(), driver(driver) { self = this; }
+            : LX_NOR_FLASH_STRUCT(), driver(driver) { ; }
 
         LevelXNorFlash(AbstractNorDriver *driver, Stm32ItmLogger::LoggerInterface *logger)
-            : Loggable(logger), LX_NOR_FLASH_STRUCT(), driver(driver) { self = this; }
+            : Loggable(logger), LX_NOR_FLASH_STRUCT(), driver(driver) { ; }
+
+        ~LevelXNorFlash();
+
+        /**
+         * Number of instances that can be open at the same time.
+         */
+        static constexpr uint8_t MAX_INSTANCES = 4;
+
+        /**
+         * Address LevelX sees for flash that is not memory mapped. The driver gets the offsets from it.
+         */
+        static constexpr uintptr_t UNMAPPED_BASE_ADDRESS = 0x10000000;
 
 
         LevelXErrorCode initialize();
 
+        /**
+         * @brief Opens the flash, from the mount checkpoint if one is set and holds a valid record.
+         *
+         * Without a valid record, LevelX scans all blocks. The first open() creates the mutex that serializes the
+         * calls to LevelX of different threads.
+         *
+         * @return ERROR if MAX_INSTANCES instances are open already or LX_DIRECT_READ is defined and the driver has
+         *         no getBaseAddress(), SYSTEM_MUTEX_CREATE_FAILED if the mutex cannot be created.
+         */
         LevelXErrorCode open();
 
+        /**
+         * @brief Closes the flash and saves its state to the mount checkpoint, if one is set.
+         */
         LevelXErrorCode close();
 
+        /**
+         * @brief Lets close() save the sector and erase counts, so open() does not have to scan the blocks.
+         *
+         * Set it before the first open(). nullptr disables the checkpoint.
+         */
+        void setMountCheckpoint(MountCheckpoint *checkpoint) { mountCheckpoint = checkpoint; }
+
+        /**
+         * @brief Returns true if the last open() restored the state from the mount checkpoint.
+         */
+        [[nodiscard]] bool isMountedFromCheckpoint() const { return mountedFromCheckpoint; }
+
+        /**
+         * @brief Erases the whole flash, so the next open() formats it.
+         *
+         * The flash is erased with AbstractNorDriver::eraseRange(), which uses the largest erase commands the
+         * device offers. LevelX then only writes the block headers when it finds the flash erased.
+         *
+         * The mount checkpoint is erased as well.
+         *
+         * @return ERROR if the flash is open or the erase failed.
+         */
+        LevelXErrorCode format();
+
         LevelXErrorCode defragment();
 
         LevelXErrorCode partialDefragment(UINT max_blocks);
@@ -65,6 +127,231 @@ namespace Stm32LevelX {
 
         LevelXErrorCode sectorWrite(ULONG logical_sector, VOID *buffer);
 
+        /**
+         * @brief Reads count consecutive logical sectors into buffer.
+         *
+         * The mappings of all sectors are looked up first, then physically consecutive sectors are read with one
+         * driver read. LevelX allocates the sectors of a block in order, so sectors that have been written together
+         * with sectorWriteRange() are usually read in one transfer. The whole range is read under the mutex of
+         * lock(), so a write or reclaim of another thread cannot move a sector between its lookup and its read.
+         *
+         * @return The error of the first sector that failed, the following sectors are not read.
+         */
+        LevelXErrorCode sectorReadRange(ULONG first_logical_sector, ULONG count, VOID *buffer);
+
+        /**
+         * @brief Writes count consecutive logical sectors from buffer.
+         *
+         * The sectors are written one after the other like sectorWrite() does, but the flash is locked only once,
+         * so the new physical sectors are allocated consecutively unless a block fills up in between.
+         *
+         * @return The error of the first sector that failed, the following sectors are not written.
+         */
+        LevelXErrorCode sectorWriteRange(ULONG first_logical_sector, ULONG count, VOID *buffer);
+
+        /**
+         * @brief Returns true if less than freeBlocks blocks of free sectors are left and obsolete sectors can be
+         *        reclaimed.
+         *
+         * The one block of free sectors that LevelX keeps for itself is not counted.
+         */
+        [[nodiscard]] bool needsPreErase(ULONG freeBlocks) const;
+
+        /**
+         * @brief Reclaims one block if needsPreErase(freeBlocks).
+         *
+         * sectorWrite() reclaims a block itself, including its erase, when only one block of free sectors is left.
+         * Calling this in idle time keeps more sectors free, so sectorWrite() rarely has to.
+         *
+         * @return SUCCESS if free sectors were gained, NO_SECTORS if there was nothing to reclaim.
+         */
+        LevelXErrorCode preErase(ULONG freeBlocks);
+
+#ifndef LX_STANDALONE_ENABLE
+        /**
+         * @brief Starts a thread that calls preErase() until freeBlocks blocks of free sectors are available.
+         *
+         * The thread checks every LIBSMART_STM32LEVELX_PRE_ERASE_INTERVAL_MS and reclaims one block at a time. Give
+         * it a lower priority than the threads that write, so it runs when they are idle. The destructor stops it.
+         *
+         * @param byte_pool Pool for the stack of LIBSMART_STM32LEVELX_PRE_ERASE_STACK_SIZE bytes.
+         * @param freeBlocks Free sector watermark in blocks.
+         * @param priority ThreadX priority of the thread.
+         */
+        UINT startPreEraseWorker(TX_BYTE_POOL *byte_pool, ULONG freeBlocks, UINT priority);
+
+        /**
+         * @brief Stops the thread after its current block and frees its stack.
+         */
+        UINT stopPreEraseWorker();
+
+        [[nodiscard]] bool isPreEraseWorkerRunning() const { return preEraseStack != nullptr; }
+#endif
+
+        /**
+         * @brief When the defragment scheduler reclaims blocks.
+         */
+        struct DefragmentPolicy {
+            UINT obsoletePercent; ///< Start once this share of the physical sectors is obsolete
+            ULONG idleMs; ///< ... and no other thread has called LevelX for this long
+            UINT blocksPerStep; ///< Blocks reclaimed by one partialDefragment(), bounds the wait of other threads
+        };
+
+        /**
+         * @brief Returns true if at least obsoletePercent percent of the physical sectors are obsolete.
+         */
+        [[nodiscard]] bool needsDefragment(UINT obsoletePercent) const;
+
+#ifndef LX_STANDALONE_ENABLE
+        /**
+         * @brief Starts a thread that calls partialDefragment() while the flash is idle.
+         *
+         * Every LIBSMART_STM32LEVELX_DEFRAGMENT_INTERVAL_MS the thread checks needsDefragment() and the time since
+         * the last call from another thread. It then reclaims policy.blocksPerStep blocks at a time until the
+         * obsolete sectors fall below the threshold, or until another thread calls LevelX. That call waits for at
+         * most one step. Give the thread a lower priority than the threads that read and write. The flash stays
+         * open. The destructor stops the thread.
+         *
+         * @param byte_pool Pool for the stack of LIBSMART_STM32LEVELX_DEFRAGMENT_STACK_SIZE bytes.
+         * @param policy When to reclaim, see DefragmentPolicy.
+         * @param priority ThreadX priority of the thread.
+         */
+        UINT startDefragmentScheduler(TX_BYTE_POOL *byte_pool, const DefragmentPolicy &policy, UINT priority);
+
+        /**
+         * @brief Stops the thread after its current step and frees its stack.
+         */
+        UINT stopDefragmentScheduler();
+
+        [[nodiscard]] bool isDefragmentSchedulerRunning() const { return defragmentStack != nullptr; }
+#endif
+
+        /**
+         * @brief Lets LevelX cache the sectors with block headers and mapping lists in memory.
+         *
+         * The cache holds up to LX_NOR_EXTENDED_CACHE_SIZE sectors of getSectorSize() bytes, more memory is not
+         * used. LevelX clears the cache in open(), so call this after open().
+         *
+         * @param memory Memory for the cache, nullptr to disable it.
+         * @param size Size of the memory in bytes.
+         * @return DISABLED if LX_NOR_DISABLE_EXTENDED_CACHE is defined.
+         */
+        LevelXErrorCode enableExtendedCache(VOID *memory, ULONG size);
+
+#ifndef LX_STANDALONE_ENABLE
+        /**
+         * @brief Allocates the cache from the byte pool passed to LevelX::setup(), see
+         *        enableExtendedCache(VOID *, ULONG).
+         *
+         * The memory is released in close() or by the next call. 0 bytes disable the cache.
+         *
+         * @return NO_MEMORY if there is no byte pool or it has not enough memory.
+         */
+        LevelXErrorCode enableExtendedCache(ULONG bytes);
+#endif
+
+        /**
+         * @brief Returns the metadata reads that LevelX served from the extended cache.
+         */
+        [[nodiscard]] ULONG getExtendedCacheHits() const;
+
+        /**
+         * @brief Returns the metadata reads that LevelX had to read from the flash into the extended cache.
+         */
+        [[nodiscard]] ULONG getExtendedCacheMisses() const;
+
+        void resetExtendedCacheCounters();
+
+        /**
+         * @brief Lets LevelX keep the mapping of every logical sector in RAM, so a lookup never reads the flash.
+         *
+         * LevelX fills the map while open() scans the blocks and keeps it current on writes, releases and
+         * reclaims. After an open() from the mount checkpoint, every entry is filled by the first lookup of its
+         * sector. Logical sectors beyond the map use the sector mapping cache of LevelX. Set the map while the
+         * flash is closed, it is used by every following open().
+         *
+         * @param memory One ULONG for each logical sector, nullptr to disable the map.
+         * @param entries Number of entries, i.e. the logical sectors 0 to entries - 1 are mapped in RAM.
+         * @return DISABLED if LX_NOR_FLASH_DIRECT_MAPPING_CACHE is not defined, ERROR if the flash is open.
+         */
+        LevelXErrorCode setDirectMapping(ULONG *memory, ULONG entries);
+
+        /**
+         * @brief Lets LevelX keep the free sector bit maps of all blocks in RAM.
+         *
+         * Without the cache, every sector allocation reads the bit map of each block it looks at from the flash.
+         * With it, blocks without free sectors are skipped and the bit map is only written. open() fills the
+         * cache while it scans the blocks, after an open() from the mount checkpoint the bit map of a block is
+         * read once, when an allocation first looks at the block. Set the cache while the flash is closed.
+         *
+         * @param memory Memory for the cache, nullptr to disable it.
+         * @param words Size of the memory in ULONGs, at least getFreeBitMapCacheWords(). With less, LevelX does not
+         *        use the cache.
+         * @return DISABLED if LX_NOR_FLASH_FREE_BIT_MAP_CACHE is not defined, ERROR if the flash is open.
+         */
+        LevelXErrorCode setFreeBitMapCache(ULONG *memory, ULONG words);
+
+        /**
+         * @brief Returns the ULONGs setFreeBitMapCache() needs for a device.
+         *
+         * @param totalBlocks Erase blocks of the device, AbstractNorDriver::getTotalSectors().
+         * @param blockSize Size of an erase block in bytes, AbstractNorDriver::getSectorSize().
+         */
+        static constexpr ULONG getFreeBitMapCacheWords(const ULONG totalBlocks, const ULONG blockSize) {
+            // Like lx_nor_flash_open(), one sector of every block holds the block header
+            const ULONG sectorsPerBlock = blockSize / sizeof(ULONG) / LX_NOR_SECTOR_SIZE - 1;
+            return LX_NOR_FLASH_FREE_BIT_MAP_CACHE_WORDS(totalBlocks, (sectorsPerBlock + 31) / 32);
+        }
+
+        /**
+         * @brief Snapshot of the counters LevelX keeps for an open flash, see getStatistics().
+         */
+        struct Statistics {
+            ULONG totalBlocks;
+            ULONG sectorsPerBlock; ///< Physical sectors per block
+            ULONG freeSectors;
+            ULONG mappedSectors;
+            ULONG obsoleteSectors;
+            ULONG minEraseCount;
+            ULONG maxEraseCount;
+
+            ULONG readRequests; ///< Sector reads and releases
+            ULONG writeRequests; ///< Sector writes
+            ULONG sectorAllocations; ///< Physical sectors allocated, by writes and by moves of the reclaim
+            ULONG sectorAllocationErrors;
+            ULONG mappingCacheHits;
+            ULONG mappingCacheMisses;
+            ULONG extendedCacheHits;
+            ULONG extendedCacheMisses;
+            ULONG blockErases; ///< Blocks erased through the driver
+            ULONG wordsWritten; ///< Words programmed through the driver, data and metadata
+            ULONG systemErrors;
+            ULONG lastSystemError;
+
+            ULONG initialFormat; ///< The flash was formatted by the last open()
+            ULONG openErasedBlocks; ///< Blocks with an interrupted erase, erased again by open()
+            ULONG openReErasedBlocks; ///< Erased blocks that failed the verify in open()
+            ULONG openSectorsObsoleted; ///< Interrupted obsolete markings completed by open()
+            ULONG openMappingsInvalidated; ///< Interrupted sector writes discarded by open()
+            ULONG openMappingWritesInterrupted;
+            ULONG openSectorsNotFree; ///< Free sectors with a mapping entry found by open()
+            ULONG openSectorDataNotFree; ///< Free sectors with data found by open()
+        };
+
+        /**
+         * @brief Returns the sector counts and the counters since the last open() or resetStatistics().
+         *
+         * The counters that start with open describe what open() found and repaired on the flash.
+         */
+        [[nodiscard]] Statistics getStatistics() const;
+
+        /**
+         * @brief Sets the request, cache, allocation, erase and error counters to 0.
+         *
+         * The sector counts and the counters of open() are kept.
+         */
+        void resetStatistics();
+
         static constexpr uint32_t getSectorSize() { return LX_NOR_SECTOR_SIZE * sizeof(ULONG); }
 
         [[nodiscard]] bool isInitialized() const { return LX_initialized; }
@@ -107,79 +394,121 @@ namespace Stm32LevelX {
         }
 
         static UINT driver_initialize(LX_NOR_FLASH *nor_flash) {
-            self->log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            auto *self = static_cast<LevelXNorFlash *>(nor_flash);
+            LIBSMART_STM32LEVELX_LOG(self->log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::LevelXNorFlash::driver_initialize()\r\n");
 
-
+            // LevelX ignores the return value, so open() has checked everything that can fail beforehand
             self->driver->initialize();
 
+            // LevelX clears its counters in every open
+            self->blockErases = 0;
+            self->wordsWritten = 0;
+
             ULONG block_size = self->driver->getSectorSize();
-            ULONG total_blocks = 512;
+            ULONG total_blocks = self->driver->getTotalSectors();
 
             /* Setup the base address of the flash memory.  */
-            // nor_flash->lx_nor_flash_base_address = nullptr;
+            nor_flash->lx_nor_flash_base_address = self->driver->getBaseAddress();
+#ifndef LX_DIRECT_READ
+            // LevelX takes a null sector address for an empty extended cache entry, so the flash must not start at 0
+            if (nor_flash->lx_nor_flash_base_address == nullptr) {
+                nor_flash->lx_nor_flash_base_address = reinterpret_cast<ULONG *>(UNMAPPED_BASE_ADDRESS);
+            }
+#endif
 
             /* Setup geometry of the flash.  */
             nor_flash->lx_nor_flash_total_blocks = total_blocks;
             nor_flash->lx_nor_flash_words_per_block = block_size / sizeof(ULONG);
 
-            nor_flash->lx_nor_flash_driver_read = nor_driver_read;
-            nor_flash->lx_nor_flash_driver_write = nor_driver_write;
+            // LevelX does not pass the instance to the driver callbacks, so every slot has its own set
+            const auto &callbacks = driverCallbacks[self->slot];
+            nor_flash->lx_nor_flash_driver_read = callbacks.read;
+            nor_flash->lx_nor_flash_driver_write = callbacks.write;
+
+            nor_flash->lx_nor_flash_driver_block_erase = callbacks.blockErase;
+            nor_flash->lx_nor_flash_driver_block_erased_verify = callbacks.blockErasedVerify;
+
+            nor_flash->lx_nor_flash_driver_system_error = callbacks.systemError;
 
-            nor_flash->lx_nor_flash_driver_block_erase = nor_driver_block_erase;
-            nor_flash->lx_nor_flash_driver_block_erased_verify = nor_driver_block_erased_verify;
+            nor_flash->lx_nor_flash_sector_buffer = &self->sectorBuffer[0];
 
-            nor_flash->lx_nor_flash_driver_system_error = nor_driver_system_error;
+#ifdef LX_NOR_FLASH_DIRECT_MAPPING_CACHE
+            // LevelX fills in the entries while it scans the blocks or on the first lookup
+            nor_flash->lx_nor_flash_direct_mapping = self->directMapping;
+            nor_flash->lx_nor_flash_direct_mapping_entries = self->directMappingEntries;
+            for (ULONG i = 0; i < self->directMappingEntries; i++) {
+                self->directMapping[i] = LX_NOR_DIRECT_MAPPING_UNKNOWN;
+            }
+#endif
+#ifdef LX_NOR_FLASH_FREE_BIT_MAP_CACHE
+            nor_flash->lx_nor_flash_free_bit_map_cache = self->freeBitMapCache;
+            nor_flash->lx_nor_flash_free_bit_map_cache_words = self->freeBitMapCacheWords;
+#endif
 
-            nor_flash->lx_nor_flash_sector_buffer = &nor_sector_memory[0];
+            self->restoreMountState();
 
             return LX_SUCCESS;
         }
 
 
+        template<uint8_t SLOT>
         static UINT nor_driver_read(ULONG *flash_address, ULONG *destination, ULONG words) {
+            LevelXNorFlash *self = instances[SLOT];
             // self->log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
                     // ->printf("Stm32LevelX::LevelXNorFlash::nor_driver_read(0x%08x, 0x%08x, %d)\r\n",
                              // flash_address, &destination, words);
 
             return self->driver->read(
-                reinterpret_cast<uint32_t>(flash_address),
+                static_cast<uint32_t>(reinterpret_cast<uintptr_t>(flash_address) -
+                                      reinterpret_cast<uintptr_t>(self->lx_nor_flash_base_address)),
                 reinterpret_cast<uint8_t *>(destination),
                 words * sizeof(ULONG)
             );
         }
 
+        template<uint8_t SLOT>
         static UINT nor_driver_write(ULONG *flash_address, ULONG *source, ULONG words) {
+            LevelXNorFlash *self = instances[SLOT];
             // self->log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
                     // ->printf("Stm32LevelX::LevelXNorFlash::nor_driver_write(0x%08x, 0x%08x, %d)\r\n",
                              // flash_address, &source, words);
 
+            self->wordsWritten += words;
             return self->driver->write(
-                reinterpret_cast<uint32_t>(flash_address),
+                static_cast<uint32_t>(reinterpret_cast<uintptr_t>(flash_address) -
+                                      reinterpret_cast<uintptr_t>(self->lx_nor_flash_base_address)),
                 reinterpret_cast<uint8_t *>(source),
                 words * sizeof(ULONG)
             );
         }
 
 
+        template<uint8_t SLOT>
         static UINT nor_driver_block_erase(ULONG block, ULONG erase_count) {
-            self->log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LevelXNorFlash *self = instances[SLOT];
+            LIBSMART_STM32LEVELX_LOG(self->log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::LevelXNorFlash::nor_driver_block_erase(0x%08x, %d)\r\n",
                              block, erase_count);
 
+            self->blockErases++;
             return self->driver->eraseSector(block * self->lx_nor_flash_words_per_block * sizeof(ULONG), erase_count);
         }
 
+        template<uint8_t SLOT>
         static UINT nor_driver_block_erased_verify(ULONG block) {
-            self->log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LevelXNorFlash *self = instances[SLOT];
+            LIBSMART_STM32LEVELX_LOG(self->log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::LevelXNorFlash::nor_driver_block_erased_verify(0x%08x)\r\n",
                              block);
 
             return self->driver->verifySectorErased(block * self->lx_nor_flash_words_per_block * sizeof(ULONG));
         }
 
+        template<uint8_t SLOT>
         static UINT nor_driver_system_error(UINT error_code) {
-            Stm32ItmLogger::logger.setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+            LevelXNorFlash *self = instances[SLOT];
+            LIBSMART_STM32LEVELX_LOG(&Stm32ItmLogger::logger, ERROR)
                     ->printf("Stm32LevelX::LevelXNorFlash::nor_driver_system_error(0x%04x) %s\r\n",
                              error_code, getErrorCodeString(static_cast<LevelXErrorCode>(error_code)));
 
@@ -189,13 +518,114 @@ namespace Stm32LevelX {
         }
 
     protected:
+        /**
+         * @brief Serializes the calls to LevelX with the mutex created by open(). Does nothing outside of a thread.
+         *
+         * Calls from other threads are recorded as foreground I/O for the defragment scheduler.
+         */
+        void lock();
+
+        void unlock();
+
+#ifndef LX_STANDALONE_ENABLE
+        /**
+         * @brief Creates the mutex of lock(), unless it exists already.
+         */
+        UINT createMutex();
+
+        /**
+         * @brief Creates the mutex, if needed, and starts a background thread with a stack from byte_pool.
+         */
+        UINT startWorker(TX_THREAD *thread, UCHAR *&stack, const char *name, VOID (*entry)(ULONG),
+                         TX_BYTE_POOL *byte_pool, ULONG stackSize, UINT priority);
+
+        /**
+         * @brief Sets stop, waits for the thread to return and frees its stack.
+         */
+        static UINT stopWorker(TX_THREAD *thread, UCHAR *&stack, volatile bool &stop);
+
+        [[nodiscard]] bool isWorker() const;
+
+        static VOID preEraseThread(ULONG input);
+
+        static VOID defragmentThread(ULONG input);
+#endif
+
+        /**
+         * @brief Hands the record taken by open() to LevelX, if it fits the geometry of the flash.
+         */
+        void restoreMountState();
+
+        /**
+         * @brief The driver callbacks of one slot.
+         */
+        struct DriverCallbacks {
+            UINT (*read)(ULONG *flash_address, ULONG *destination, ULONG words);
+            UINT (*write)(ULONG *flash_address, ULONG *source, ULONG words);
+            UINT (*blockErase)(ULONG block, ULONG erase_count);
+            UINT (*blockErasedVerify)(ULONG block);
+            UINT (*systemError)(UINT error_code);
+        };
+
+        template<uint8_t SLOT>
+        static constexpr DriverCallbacks getDriverCallbacks() {
+            return {
+                nor_driver_read<SLOT>, nor_driver_write<SLOT>, nor_driver_block_erase<SLOT>,
+                nor_driver_block_erased_verify<SLOT>, nor_driver_system_error<SLOT>
+            };
+        }
+
+        static const DriverCallbacks driverCallbacks[MAX_INSTANCES];
+        static LevelXNorFlash *instances[MAX_INSTANCES];
+
+        /**
+         * @brief Takes a free slot in instances, unless this instance has one already.
+         *
+         * @return false if all slots are taken.
+         */
+        bool attach();
+
+        /**
+         * @brief Frees the slot of this instance.
+         */
+        void detach();
+
         AbstractNorDriver *driver;
-        static LevelXNorFlash *self;
+        uint8_t slot = MAX_INSTANCES;
+        ULONG sectorBuffer[LX_NOR_SECTOR_SIZE] = {};
+        ULONG blockErases = 0;
+        ULONG wordsWritten = 0;
+        ULONG *directMapping = nullptr;
+        ULONG directMappingEntries = 0;
+        ULONG *freeBitMapCache = nullptr;
+        ULONG freeBitMapCacheWords = 0;
+        MountCheckpoint *mountCheckpoint = nullptr;
+        MountCheckpoint::Record mountRecord = {};
+        bool mountRecordTaken = false;
+        bool mountedFromCheckpoint = false;
         bool LX_initialized = false;
         bool LX_open = false;
+#ifndef LX_STANDALONE_ENABLE
+        TX_MUTEX mutex = {};
+        bool mutexCreated = false;
+        TX_THREAD preEraseThreadStruct = {};
+        VOID *extendedCacheMemory = nullptr;
+        UCHAR *preEraseStack = nullptr;
+        volatile ULONG preEraseFreeBlocks = 0;
+        volatile bool preEraseStop = false;
+        TX_THREAD defragmentThreadStruct = {};
+        UCHAR *defragmentStack = nullptr;
+        DefragmentPolicy defragmentPolicy = {};
+        volatile bool defragmentStop = false;
+        volatile ULONG lastForegroundTime = 0;
+#endif
+    };
+
+    inline constexpr LevelXNorFlash::DriverCallbacks LevelXNorFlash::driverCallbacks[MAX_INSTANCES] = {
+        getDriverCallbacks<0>(), getDriverCallbacks<1>(), getDriverCallbacks<2>(), getDriverCallbacks<3>()
     };
 
-    inline LevelXNorFlash *LevelXNorFlash::self = {};
+    inline LevelXNorFlash *LevelXNorFlash::instances[MAX_INSTANCES] = {};
 }
 
 #endif
@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_LOGLEVEL_HPP
+#define LIBSMART_STM32LEVELX_LOGLEVEL_HPP
+
+#include <libsmart_config.hpp>
+
+#include "Loggable.hpp"
+
+#ifndef LIBSMART_STM32LEVELX_LOG_LEVEL
+#ifdef NDEBUG
+#define LIBSMART_STM32LEVELX_LOG_LEVEL WARNING
+#else
+#define LIBSMART_STM32LEVELX_LOG_LEVEL INFORMATIONAL
+#endif
+#endif
+
+namespace Stm32LevelX {
+    /**
+     * @brief Least severe message that is compiled in, see LIBSMART_STM32LEVELX_LOG().
+     */
+    constexpr auto LOG_LEVEL = Stm32ItmLogger::LoggerInterface::Severity::LIBSMART_STM32LEVELX_LOG_LEVEL;
+
+    /**
+     * @brief Returns true if messages of the severity are compiled in.
+     *
+     * The severities are ordered like the syslog levels, from EMERGENCY down to DEBUG.
+     */
+    constexpr bool isLogged(const Stm32ItmLogger::LoggerInterface::Severity severity) {
+        return static_cast<int>(severity) <= static_cast<int>(LOG_LEVEL);
+    }
+}
+
+/**
+ * @brief Sets the severity of the logger, if messages of this severity are compiled in.
+ *
+ * Used as LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)->printf(...). If the severity is less severe than
+ * LIBSMART_STM32LEVELX_LOG_LEVEL, the whole statement is discarded at compile time, including the evaluation of
+ * the arguments. The driver primitives log on every call, e.g. Sst26Driver::RDSR() while polling the busy bit,
+ * so release builds should not compile them in.
+ */
+#define LIBSMART_STM32LEVELX_LOG(logger, severity) \
+    if constexpr (!Stm32LevelX::isLogged(Stm32ItmLogger::LoggerInterface::Severity::severity)) {} else \
+        (logger)->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::severity)
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstddef>
+
+#include "MountCheckpoint.hpp"
+#include "Crc32.hpp"
+
+using namespace Stm32LevelX;
+
+bool MountCheckpoint::take(Record &record) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::MountCheckpoint::take()\r\n");
+
+    if (!scan() || !newestValid || newest.consumed != 0xFFFFFFFF) return false;
+
+    // Consumed before the volume is used, so a dirty shutdown leaves no valid record behind
+    uint32_t consumed = 0;
+    const uint32_t addr = getSlotAddress(nextSlot - 1) + offsetof(Record, consumed);
+    if (driver->write(addr, reinterpret_cast<uint8_t *>(&consumed), sizeof(consumed)) != LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::MountCheckpoint::take() write(0x%08x) failed\r\n", addr);
+        return false;
+    }
+    newest.consumed = consumed;
+
+    record = newest;
+    return true;
+}
+
+bool MountCheckpoint::save(Record &record) {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::MountCheckpoint::save()\r\n");
+
+    if (!scan()) return false;
+
+    if (nextSlot >= slots) {
+        if (driver->eraseSector(address, 0) != LX_SUCCESS) {
+            LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                    ->printf("Stm32LevelX::MountCheckpoint::save() eraseSector(0x%08x) failed\r\n", address);
+            return false;
+        }
+        nextSlot = 0;
+    }
+
+    record.magic = MAGIC;
+    record.generation = ++generation;
+    record.crc = calculateCrc(record);
+    record.consumed = 0xFFFFFFFF;
+
+    newestValid = false;
+    if (driver->write(getSlotAddress(nextSlot), reinterpret_cast<uint8_t *>(&record), sizeof(record)) !=
+        LX_SUCCESS) {
+        LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                ->printf("Stm32LevelX::MountCheckpoint::save() write(0x%08x) failed\r\n", getSlotAddress(nextSlot));
+        nextSlot++;
+        return false;
+    }
+    nextSlot++;
+    newest = record;
+    newestValid = true;
+    return true;
+}
+
+bool MountCheckpoint::invalidate() {
+    LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
+            ->printf("Stm32LevelX::MountCheckpoint::invalidate()\r\n");
+
+    if (!prepare() || driver->eraseSector(address, 0) != LX_SUCCESS) {
+        scanned = false;
+        return false;
+    }
+    nextSlot = 0;
+    newestValid = false;
+    scanned = true;
+    return true;
+}
+
+bool MountCheckpoint::scan() {
+    if (scanned) return true;
+
+    if (!prepare()) return false;
+    nextSlot = 0;
+    newestValid = false;
+
+    uint32_t previousGeneration = 0;
+    for (uint32_t slot = 0; slot < slots; slot++) {
+        Record record;
+        if (driver->read(getSlotAddress(slot), reinterpret_cast<uint8_t *>(&record), sizeof(record)) !=
+            LX_SUCCESS) {
+            return false;
+        }
+        if (record.magic == 0xFFFFFFFF) break;
+
+        // A damaged or out of order record is skipped, but its slot stays used
+        nextSlot = slot + 1;
+        newestValid = record.magic == MAGIC && record.crc == calculateCrc(record) &&
+                      record.generation > previousGeneration;
+        if (newestValid) {
+            newest = record;
+            previousGeneration = record.generation;
+            generation = record.generation;
+        }
+    }
+
+    scanned = true;
+    return true;
+}
+
+bool MountCheckpoint::prepare() {
+    // Initializing the device again would reset it under the erases and programs of the volumes
+    if (driver->getSectorSize() == 0 && driver->initialize() != LX_SUCCESS) return false;
+    slots = driver->getSectorSize() / sizeof(Record);
+    return slots > 0;
+}
+
+uint32_t MountCheckpoint::calculateCrc(const Record &record) {
+    Crc32 crc;
+    crc.update(reinterpret_cast<const uint8_t *>(&record), offsetof(Record, crc));
+    return crc.get();
+}
@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_MOUNTCHECKPOINT_HPP
+#define LIBSMART_STM32LEVELX_MOUNTCHECKPOINT_HPP
+
+#include <libsmart_config.hpp>
+#include <main.h>
+
+#include "AbstractNorDriver.hpp"
+#include "Loggable.hpp"
+#include "LogLevel.hpp"
+
+namespace Stm32LevelX {
+    /**
+     * @brief State of a LevelX NOR flash after a clean close, kept in one erase sector outside of the volume.
+     *
+     * LevelXNorFlash::close() appends a record, LevelXNorFlash::open() restores the state from the newest record
+     * instead of scanning all blocks. The record is marked as consumed before the volume is opened, so after a
+     * dirty shutdown no valid record is left and the next open() scans the blocks again. Every record carries a
+     * generation number, which increases with every close(). Records are appended until the sector is full, then
+     * the sector is erased.
+     *
+     * All writers of the volume must use the same checkpoint. A volume written without it, e.g. by an older
+     * firmware, must be opened once with the checkpoint invalidated.
+     */
+    class MountCheckpoint : public Stm32ItmLogger::Loggable {
+    public:
+        struct Record {
+            uint32_t magic;
+            uint32_t generation;
+            uint32_t totalBlocks;
+            uint32_t wordsPerBlock;
+            uint32_t freeSectors;
+            uint32_t mappedSectors;
+            uint32_t obsoleteSectors;
+            uint32_t minEraseCount;
+            uint32_t maxEraseCount;
+            uint32_t freeBlockSearch;
+            uint32_t crc; ///< CRC of the words above
+            uint32_t consumed; ///< Programmed to 0 when open() uses the record
+        };
+
+        static constexpr uint32_t MAGIC = 0x5043584C; // "LXCP"
+
+        /**
+         * The checkpoint does not initialize the device, the volume that uses it has done so. Only a driver that
+         * reports no sector size yet, like a PartitionNorDriver before its first initialize(), is initialized
+         * once. A partition does not reset a device that another partition has initialized.
+         *
+         * @param driver Device that holds the checkpoint, e.g. a PartitionNorDriver of one sector.
+         * @param address Address of the erase sector on the device.
+         */
+        MountCheckpoint(AbstractNorDriver *driver, const uint32_t address)
+            : driver(driver), address(address) { ; }
+
+        MountCheckpoint(AbstractNorDriver *driver, const uint32_t address, Stm32ItmLogger::LoggerInterface *logger)
+            : Loggable(logger), driver(driver), address(address) { ; }
+
+        /**
+         * @brief Reads the newest record and marks it as consumed.
+         *
+         * @return false if there is no record, the newest one is damaged, older than its predecessor or consumed
+         *         already, or it could not be marked.
+         */
+        bool take(Record &record);
+
+        /**
+         * @brief Appends a record with the next generation number.
+         */
+        bool save(Record &record);
+
+        /**
+         * @brief Erases the sector, so the next open() scans the blocks.
+         */
+        bool invalidate();
+
+    protected:
+        /**
+         * @brief Finds the newest record and the next free slot, once after the start.
+         */
+        bool scan();
+
+        /**
+         * @brief Initializes the driver if it does not know its sector size yet, and sizes the slots.
+         *
+         * @return false if the driver fails or the sector does not hold a single record.
+         */
+        bool prepare();
+
+        [[nodiscard]] static uint32_t calculateCrc(const Record &record);
+
+        [[nodiscard]] uint32_t getSlotAddress(const uint32_t slot) const {
+            return address + slot * static_cast<uint32_t>(sizeof(Record));
+        }
+
+        AbstractNorDriver *driver;
+        uint32_t address;
+        uint32_t slots = 0;
+        uint32_t nextSlot = 0;
+        uint32_t generation = 0;
+        bool scanned = false;
+        bool newestValid = false;
+        Record newest = {};
+    };
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include "AbstractNorDriver.hpp"
 #include "Stm32ItmLogger.hpp"
 #include "Loggable.hpp"
+#include "LogLevel.hpp"
 #include "lx_api.h"
 
 namespace Stm32LevelX {
@@ -29,13 +30,28 @@ namespace Stm32LevelX {
         AbstractNorDriver *driver;
 
     public:
+        /**
+         * @brief Keeps the byte pool that the library allocates its memory from, e.g. for
+         *        LevelXNorFlash::enableExtendedCache().
+         */
         static UINT setup(TX_BYTE_POOL *byte_pool) {
-            Stm32ItmLogger::logger.setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(&Stm32ItmLogger::logger, INFORMATIONAL)
                     ->println("Stm32LevelX::LevelX::setup()");
 
+            bytePool = byte_pool;
             return TX_SUCCESS;
         }
+
+        /**
+         * @brief Returns the byte pool passed to setup(), nullptr before.
+         */
+        static TX_BYTE_POOL *getBytePool() { return bytePool; }
+
+    protected:
+        static TX_BYTE_POOL *bytePool;
     };
+
+    inline TX_BYTE_POOL *LevelX::bytePool = nullptr;
 }
 
 #endif //LIBSMART_STM32LEVELX_STM32LEVELX_HPP
@@ -20,57 +20,51 @@ namespace Stm32LevelX {
 
 
         void initializeDefault() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Store::initializeDefault()\r\n");
             std::memset(rawData, LIBSMART_STM32LEVELX_STORE_INITIALIZE_BYTE, sizeof(rawData));
             data = new(rawData) STORED_OBJECT();
         }
 
         bool read() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Store::read()\r\n");
 
             open();
 
-            for (uint32_t i = 0; i < SECTORS; i++) {
-                uint8_t *addr = reinterpret_cast<uint8_t *>(rawData) + i * SECTOR_SIZE;
-                const auto ret = LX->sectorRead(logicalSector + i, addr);
-                if (ret != LevelXErrorCode::SUCCESS) {
-                    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
-                            ->printf("LX->sectorRead(%d, %p) = 0x%02x\r\n", logicalSector, rawData, ret);
-                    return false;
-                }
-                log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::NOTICE)
-                        ->printf("LX->sectorRead(%d, %p) = 0x%02x\r\n", logicalSector, rawData, ret);
+            const auto ret = LX->sectorReadRange(logicalSector, SECTORS, rawData);
+            if (ret != LevelXErrorCode::SUCCESS) {
+                LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                        ->printf("LX->sectorReadRange(%d, %d, %p) = 0x%02x\r\n", logicalSector, SECTORS, rawData, ret);
+                return false;
             }
+            LIBSMART_STM32LEVELX_LOG(log(), NOTICE)
+                    ->printf("LX->sectorReadRange(%d, %d, %p) = 0x%02x\r\n", logicalSector, SECTORS, rawData, ret);
 
             return true;
         }
 
         bool write() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Store::write()\r\n");
 
             open();
 
-            for (uint32_t i = 0; i < SECTORS; i++) {
-                uint8_t *addr = reinterpret_cast<uint8_t *>(rawData) + i * SECTOR_SIZE;
-                const auto ret = LX->sectorWrite(logicalSector + i, addr);
-                if (ret != LevelXErrorCode::SUCCESS) {
-                    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
-                            ->printf("LX->sectorWrite(%d, %p) = 0x%02x\r\n", logicalSector, addr, ret);
-                    return false;
-                }
-                log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::NOTICE)
-                        ->printf("LX->sectorWrite(%d, %p) = 0x%02x\r\n", logicalSector, addr, ret);
+            const auto ret = LX->sectorWriteRange(logicalSector, SECTORS, rawData);
+            if (ret != LevelXErrorCode::SUCCESS) {
+                LIBSMART_STM32LEVELX_LOG(log(), ERROR)
+                        ->printf("LX->sectorWriteRange(%d, %d, %p) = 0x%02x\r\n", logicalSector, SECTORS, rawData, ret);
+                return false;
             }
+            LIBSMART_STM32LEVELX_LOG(log(), NOTICE)
+                    ->printf("LX->sectorWriteRange(%d, %d, %p) = 0x%02x\r\n", logicalSector, SECTORS, rawData, ret);
 
             return true;
         }
 
 
         bool release() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Store::release()\r\n");
 
             open();
@@ -78,7 +72,7 @@ namespace Stm32LevelX {
             for (uint32_t i = 0; i < SECTORS; i++) {
                 const auto ret = LX->sectorRelease(logicalSector + i);
                 if (ret != LevelXErrorCode::SUCCESS) {
-                    log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
+                    LIBSMART_STM32LEVELX_LOG(log(), ERROR)
                             ->printf("LX->sectorRelease(%d) = 0x%02x\r\n", logicalSector, ret);
                     return false;
                 }
@@ -89,7 +83,7 @@ namespace Stm32LevelX {
 
 
         bool open() {
-            log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::INFORMATIONAL)
+            LIBSMART_STM32LEVELX_LOG(log(), INFORMATIONAL)
                     ->printf("Stm32LevelX::Store::open()\r\n");
 
             bool ret = true;
@@ -7,5 +7,7 @@
 
 #define LIBSMART_STM32LEVELX_STORE_INITIALIZE_BYTE 0x00
 
-#define LIBSMART_STM32LEVELX_PP_READ_BACK_TEST
+#define LIBSMART_STM32LEVELX_VERIFY_POLICY FULL
 
+// Least severe log message that is compiled in, WARNING with NDEBUG and INFORMATIONAL otherwise
+// #define LIBSMART_STM32LEVELX_LOG_LEVEL WARNING
@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * JedecSpiNorDriver::initialize() on the SFDP tables of several vendors.
+ *
+ * The BFPT DWORDs are the values the datasheets list in their SFDP tables. Each one is wrapped into an SFDP
+ * header with a single parameter header and served by the simulated transport, together with the JEDEC ID
+ * of the part. The driver must pick the read instruction, the erase types, the page size and the busy
+ * polling from the table, and remove the write protection the way the vendor requires.
+ */
+
+#include <vector>
+
+#include "Test.hpp"
+#include "LevelXNorFlash.hpp"
+#include "Driver/JedecSpiNorDriver.hpp"
+#include "Driver/Transport/SimulatedSpiTransport.hpp"
+
+using namespace Stm32LevelX;
+using namespace Stm32LevelX::Driver;
+
+struct SfdpDump {
+    const char *part;
+    uint8_t jedecId[3];
+    uint8_t bfptDwords;
+    uint32_t bfpt[16];
+
+    // Expected configuration
+    uint32_t totalSize;
+    uint32_t eraseSizes[3];
+    bool flagStatusPolling;
+    JedecSpiNorDriver::ReadCommand read[3]; ///< On 1, 2 and 4 lanes
+};
+
+static const SfdpDump dumps[] = {
+    {
+        "W25Q128JV", {0xEF, 0x40, 0x18}, 16,
+        {
+            0xFFF120E5, 0x07FFFFFF, 0x6B08EB44, 0xBB423B08, 0xFFFFFFEE, 0xFF00FFFF, 0xFF00FFFF, 0x520F200C,
+            0xFF00D810, 0x00A60221, 0x33F78281, 0xE9FA5F0F, 0xA8B06B11, 0xF77A75C4, 0xB04B5A20, 0x00000000
+        },
+        16 * 1024 * 1024, {4096, 32768, 65536}, false,
+        {{0x0B, 1, 1, 1}, {0xBB, 2, 2, 1}, {0xEB, 4, 4, 3}}
+    },
+    {
+        "MX25L12835F", {0xC2, 0x20, 0x18}, 16,
+        {
+            0xFFF120E5, 0x07FFFFFF, 0x6B08EB44, 0xBB043B08, 0xFFFFFFEE, 0xFF00FFFF, 0xFF00FFFF, 0x520F200C,
+            0xFF00D810, 0x00000000, 0x00000081, 0x00000000, 0x00000000, 0x00000004, 0x00200000, 0x00000000
+        },
+        16 * 1024 * 1024, {4096, 32768, 65536}, false,
+        {{0x0B, 1, 1, 1}, {0xBB, 2, 2, 1}, {0xEB, 4, 4, 3}}
+    },
+    {
+        "MT25QL128", {0x20, 0xBA, 0x18}, 16,
+        {
+            0xFFF120E5, 0x07FFFFFF, 0x6B08EB0A, 0xBB083B08, 0xFFFFFFEE, 0xFF00FFFF, 0xFF00FFFF, 0xD810200C,
+            0x00000000, 0x00000000, 0x00000081, 0x00000000, 0x00000000, 0x00000008, 0x00000000, 0x00000000
+        },
+        16 * 1024 * 1024, {4096, 65536, 0}, true,
+        {{0x0B, 1, 1, 1}, {0xBB, 2, 2, 2}, {0xEB, 4, 4, 5}}
+    },
+    {
+        // A JESD216 (rev. 0) table with 9 DWORDs, which does not tell how to set the QE bit
+        "JESD216 9 DWORDs", {0xEF, 0x40, 0x17}, 9,
+        {0xFFF120E5, 0x00FFFFFF, 0x6B08EB44, 0xBB423B08, 0xFFFFFFEE, 0xFF00FFFF, 0xFF00FFFF, 0x520F200C, 0xFF00D810},
+        2 * 1024 * 1024, {4096, 32768, 65536}, false,
+        {{0x0B, 1, 1, 1}, {0xBB, 2, 2, 1}, {0xBB, 2, 2, 1}}
+    },
+};
+
+static std::vector<uint8_t> buildImage(const SfdpDump &dump) {
+    std::vector<uint8_t> image(0x30 + sizeof(dump.bfpt), 0xFF);
+    const auto put = [&image](const uint32_t offset, const uint32_t value) {
+        for (uint8_t i = 0; i < 4; i++) image[offset + i] = value >> (8 * i);
+    };
+    // "SFDP", revision 1.6, one parameter header
+    put(0x00, 0x50444653);
+    put(0x04, 0xFF000106);
+    // BFPT revision 1.6 with its length in DWORDs, at 0x30
+    put(0x08, 0x00010600 | static_cast<uint32_t>(dump.bfptDwords) << 24);
+    put(0x0C, 0xFF000030);
+    for (uint8_t i = 0; i < dump.bfptDwords; i++) put(0x30 + 4 * i, dump.bfpt[i]);
+    return image;
+}
+
+static void checkConfiguration(const SfdpDump &dump) {
+    static std::vector<uint8_t> memory(16 * 1024 * 1024);
+    const auto image = buildImage(dump);
+    const uint8_t lanes[3] = {1, 2, 4};
+    for (uint8_t l = 0; l < 3; l++) {
+        VirtualClock clock;
+        SimulatedSpiTransport transport(memory.data(), memory.size(), &clock);
+        transport.setMaxLanes(lanes[l]);
+        transport.setSfdp(image.data(), image.size());
+        transport.setJedecId(dump.jedecId);
+        JedecSpiNorDriver driver(&transport);
+        std::printf("%s on %u lanes\n", dump.part, lanes[l]);
+
+        CHECK(driver.initialize() == LX_SUCCESS);
+        CHECK(driver.getManufacturerId() == dump.jedecId[0]);
+        CHECK(driver.getTotalSize() == dump.totalSize);
+        CHECK(driver.getPageSize() == 256);
+        CHECK(driver.getSectorSize() == 4096);
+        CHECK(driver.isFlagStatusPolling() == dump.flagStatusPolling);
+        for (uint8_t i = 0; i < 3; i++) CHECK(driver.getEraseType(i).size == dump.eraseSizes[i]);
+        const auto &read = driver.getReadCommand();
+        CHECK(read.opcode == dump.read[l].opcode);
+        CHECK(read.addressLanes == dump.read[l].addressLanes);
+        CHECK(read.dataLanes == dump.read[l].dataLanes);
+        CHECK(read.dummyBytes == dump.read[l].dummyBytes);
+        // Only SST26 parts are unlocked with ULBPR
+        CHECK(transport.getCounters().opcodes[JedecSpiNorDriver::Instruction::ULBPR] == 0);
+    }
+}
+
+/**
+ * Runs LevelX on the driver and checks that no program or erase has been rejected.
+ */
+static void checkLevelX(SimulatedSpiTransport &transport, const uint8_t expectedUlbpr) {
+    transport.format();
+    JedecSpiNorDriver driver(&transport);
+    LevelXNorFlash lx(&driver);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+
+    constexpr ULONG SECTORS = 1500;
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (int round = 0; round < 2; round++) {
+        for (ULONG s = 0; s < SECTORS; s++) {
+            for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) buffer[i] = s * 7 + i + round;
+            CHECK(lx.sectorWrite(s, buffer) == LevelXErrorCode::SUCCESS);
+        }
+    }
+    for (ULONG s = 0; s < SECTORS; s++) {
+        CHECK(lx.sectorRead(s, buffer) == LevelXErrorCode::SUCCESS);
+        for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) CHECK(buffer[i] == s * 7 + i + 1);
+    }
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+
+    const auto &counters = transport.getCounters();
+    CHECK(!transport.isBlocksProtected());
+    CHECK(counters.opcodes[JedecSpiNorDriver::Instruction::ULBPR] >= expectedUlbpr);
+    CHECK(counters.rejectedWrites == 0);
+    CHECK(counters.busyViolations == 0);
+    CHECK(counters.encodingErrors == 0);
+}
+
+int main() {
+    for (const auto &dump: dumps) checkConfiguration(dump);
+
+    static std::vector<uint8_t> memory(16 * 1024 * 1024);
+    VirtualClock clock;
+
+    // The default image of the simulated transport is an SST26VF016B, which powers up write protected
+    SimulatedSpiTransport sst26(memory.data(), 2 * 1024 * 1024, &clock);
+    checkLevelX(sst26, 1);
+
+    // The W25Q128JV has no protected blocks after power-up, the simulated device does not model its BP bits
+    const auto image = buildImage(dumps[0]);
+    SimulatedSpiTransport w25q(memory.data(), memory.size(), &clock);
+    w25q.setMaxLanes(4);
+    w25q.setSfdp(image.data(), image.size());
+    w25q.setJedecId(dumps[0].jedecId);
+    w25q.setBlocksProtected(false);
+    checkLevelX(w25q, 0);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Runs LevelX on the SimulatedNorDriver: overwrites a set of logical sectors several times, so that
+ * reclaims happen, and checks the data before and after a close/open cycle.
+ */
+
+#include <vector>
+
+#include "Test.hpp"
+#include "LevelXNorFlash.hpp"
+#include "Driver/SimulatedNorDriver.hpp"
+
+using namespace Stm32LevelX;
+
+static constexpr ULONG SECTORS = 3000;
+static constexpr int ROUNDS = 10;
+
+static ULONG pattern(const ULONG sector, const unsigned i, const int round) {
+    return sector * 1000 + i + round;
+}
+
+static void checkSectors(LevelXNorFlash &lx) {
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (ULONG s = 0; s < SECTORS; s++) {
+        CHECK(lx.sectorRead(s, buffer) == LevelXErrorCode::SUCCESS);
+        for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) CHECK(buffer[i] == pattern(s, i, ROUNDS - 1));
+    }
+}
+
+int main() {
+    static std::vector<uint8_t> memory(2 * 1024 * 1024);
+    Driver::VirtualClock clock;
+    Driver::SimulatedNorDriver sim(memory.data(), memory.size(), &clock);
+    sim.format();
+
+    LevelXNorFlash lx(&sim);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (int round = 0; round < ROUNDS; round++) {
+        for (ULONG s = 0; s < SECTORS; s++) {
+            for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) buffer[i] = pattern(s, i, round);
+            CHECK(lx.sectorWrite(s, buffer) == LevelXErrorCode::SUCCESS);
+        }
+    }
+    CHECK(sim.getCounters().sectorErases > 0);
+    checkSectors(lx);
+
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+    checkSectors(lx);
+
+    CHECK(sim.getCounters().programConflicts == 0);
+    std::printf("simulated time %.1f ms, %u erases\n", clock.now() / 1e6, sim.getCounters().sectorErases);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Sst26Driver::readAsync() must own the bus until its transfer has finished, and must not start while a
+ * program or an erase is pending.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "Test.hpp"
+#include "Driver/Sst26Driver.hpp"
+#include "Driver/Transport/SimulatedSpiTransport.hpp"
+
+using namespace Stm32LevelX;
+using namespace Stm32LevelX::Driver;
+
+struct Completion {
+    bool called;
+    UINT status;
+};
+
+static void onComplete(const UINT status, void *context) {
+    const auto completion = static_cast<Completion *>(context);
+    completion->called = true;
+    completion->status = status;
+}
+
+int main() {
+    static std::vector<uint8_t> memory(2 * 1024 * 1024);
+    VirtualClock clock;
+    SimulatedSpiTransport transport(memory.data(), memory.size(), &clock);
+    transport.format();
+    Sst26Driver driver(&transport);
+    CHECK(driver.initialize() == LX_SUCCESS);
+
+    uint8_t data[256], buffer[256];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = static_cast<uint8_t>(i * 13 + 7);
+    CHECK(driver.write(0, data, sizeof(data)) == LX_SUCCESS);
+
+    // The transfer holds the bus until it has completed
+    transport.setDeferAsync(true);
+    Completion completion = {};
+    CHECK(driver.readAsync(0, buffer, sizeof(buffer), onComplete, &completion) == LX_SUCCESS);
+    CHECK(transport.isLocked());
+    CHECK(!completion.called);
+    Completion second = {};
+    CHECK(driver.readAsync(0, buffer, sizeof(buffer), onComplete, &second) == LX_ERROR);
+    CHECK(transport.completeAsync());
+    CHECK(completion.called && completion.status == LX_SUCCESS);
+    CHECK(!second.called);
+    CHECK(!transport.isLocked());
+    CHECK(std::memcmp(buffer, data, sizeof(data)) == 0);
+    transport.setDeferAsync(false);
+
+    // Rejected while an erase is pending
+    CHECK(driver.startEraseSector(Sst26Driver::SECTOR_SIZE, 0) == LX_SUCCESS);
+    completion = {};
+    CHECK(driver.readAsync(0, buffer, sizeof(buffer), onComplete, &completion) == LX_ERROR);
+    CHECK(!completion.called);
+    CHECK(!transport.isLocked());
+    CHECK(driver.finish() == LX_SUCCESS);
+
+    // Rejected while a program is pending
+    CHECK(driver.startWrite(2 * Sst26Driver::SECTOR_SIZE, data, sizeof(data)) == LX_SUCCESS);
+    CHECK(driver.readAsync(0, buffer, sizeof(buffer), onComplete, &completion) == LX_ERROR);
+    CHECK(!transport.isLocked());
+    CHECK(driver.finish() == LX_SUCCESS);
+
+    std::memset(buffer, 0, sizeof(buffer));
+    CHECK(driver.readAsync(2 * Sst26Driver::SECTOR_SIZE, buffer, sizeof(buffer), onComplete, &completion) == LX_SUCCESS);
+    CHECK(completion.called && completion.status == LX_SUCCESS);
+    CHECK(std::memcmp(buffer, data, sizeof(data)) == 0);
+    CHECK(!transport.isLocked());
+    CHECK(transport.getCounters().busyViolations == 0);
+    return EXIT_SUCCESS;
+}
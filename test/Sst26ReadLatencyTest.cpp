@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Latency of reads that arrive while Sst26Driver waits for a sector erase, with and without erase suspend.
+ *
+ * LevelX runs on the simulated SST26. Every time the driver waits for the device, delayHook issues a read
+ * outside of the block that is being erased, as another thread would. The reads suspend the erase, but only
+ * MAX_SUSPENSIONS_PER_ERASE times, so the erase still finishes within its timeout.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "Test.hpp"
+#include "LevelXNorFlash.hpp"
+#include "Driver/Sst26Driver.hpp"
+#include "Driver/Transport/SimulatedSpiTransport.hpp"
+
+using namespace Stm32LevelX;
+using namespace Stm32LevelX::Driver;
+
+class TestDriver : public Sst26Driver {
+public:
+    using Sst26Driver::Sst26Driver;
+
+    [[nodiscard]] bool isErasing() const { return pendingErase != 0; }
+    [[nodiscard]] uint32_t getEraseAddr() const { return pendingEraseAddr; }
+    [[nodiscard]] uint8_t getPendingEraseSuspensions() const { return pendingEraseSuspensions; }
+};
+
+struct Latency {
+    uint32_t reads;
+    uint32_t failed;
+    uint64_t sum_ns;
+    uint64_t worst_ns;
+    uint8_t maxSuspensions;
+};
+
+static TestDriver *driver;
+static VirtualClock *virtualClock;
+static Latency latency;
+static bool inHook;
+
+static uint32_t virtualMillis() { return static_cast<uint32_t>(virtualClock->now() / 1000000); }
+
+static void readWhileErasing() {
+    if (inHook || !driver->isErasing()) return;
+    inHook = true;
+    // Spread the reads over the upper half of the device, away from the erase
+    uint32_t addr = (latency.reads * 7919 * 512) % 0x100000 + 0x100000;
+    if ((addr & ~(Sst26Driver::SECTOR_SIZE - 1)) == driver->getEraseAddr()) addr ^= 0x80000;
+
+    static uint8_t buffer[512];
+    const uint64_t start = virtualClock->now();
+    if (driver->read(addr, buffer, sizeof(buffer)) != LX_SUCCESS) latency.failed++;
+    const uint64_t duration = virtualClock->now() - start;
+    latency.reads++;
+    latency.sum_ns += duration;
+    latency.worst_ns = std::max(latency.worst_ns, duration);
+    latency.maxSuspensions = std::max(latency.maxSuspensions, driver->getPendingEraseSuspensions());
+    inHook = false;
+}
+
+static Latency measure(const bool eraseSuspend) {
+    static std::vector<uint8_t> memory(2 * 1024 * 1024);
+    VirtualClock testClock;
+    SimulatedSpiTransport transport(memory.data(), memory.size(), &testClock);
+    transport.format();
+    transport.setPollInterval(1000000);
+    TestDriver testDriver(&transport);
+    testDriver.setEraseSuspend(eraseSuspend);
+    driver = &testDriver;
+    virtualClock = &testClock;
+
+    LevelXNorFlash lx(&testDriver);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+
+    latency = {};
+    millisHook = virtualMillis;
+    delayHook = readWhileErasing;
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (int round = 0; round < 4; round++) {
+        for (ULONG s = 0; s < 3000; s++) {
+            for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) buffer[i] = s * 1000 + i + round;
+            CHECK(lx.sectorWrite(s, buffer) == LevelXErrorCode::SUCCESS);
+        }
+    }
+    delayHook = nullptr;
+    millisHook = nullptr;
+
+    for (ULONG s = 0; s < 3000; s++) {
+        CHECK(lx.sectorRead(s, buffer) == LevelXErrorCode::SUCCESS);
+        for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) CHECK(buffer[i] == s * 1000 + i + 3);
+    }
+    const auto &counters = transport.getCounters();
+    CHECK(counters.busyViolations == 0);
+    CHECK(counters.rejectedWrites == 0);
+
+    std::printf("erase suspend %s: %u reads during erases, worst %.3f ms, average %.3f ms, %u suspensions\n",
+                eraseSuspend ? "on " : "off", latency.reads, latency.worst_ns / 1e6,
+                latency.reads > 0 ? latency.sum_ns / 1e6 / latency.reads : 0.0, testDriver.getEraseSuspensions());
+    return latency;
+}
+
+int main() {
+    const Latency waiting = measure(false);
+    const Latency suspending = measure(true);
+
+    CHECK(waiting.reads > 0 && suspending.reads > 0);
+    CHECK(waiting.failed == 0 && suspending.failed == 0);
+    CHECK(waiting.maxSuspensions == 0);
+    CHECK(suspending.maxSuspensions > 0);
+    CHECK(suspending.maxSuspensions <= Sst26Driver::MAX_SUSPENSIONS_PER_ERASE);
+    // Suspending the erase must cut the average latency of the reads at least in half
+    CHECK(suspending.sum_ns * waiting.reads * 2 < waiting.sum_ns * suspending.reads);
+    return EXIT_SUCCESS;
+}
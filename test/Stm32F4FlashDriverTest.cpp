@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Runs the Stm32F4FlashDriver on its RAM image: checks which sector ranges initialize() accepts and the
+ * block size it groups them into, then formats LevelX on each valid range, overwrites the logical sectors
+ * until blocks are reclaimed and checks the data before and after a close/open cycle.
+ */
+
+#include <vector>
+
+#include "Test.hpp"
+#include "LevelXNorFlash.hpp"
+#include "Driver/Stm32F4FlashDriver.hpp"
+
+using namespace Stm32LevelX;
+using namespace Stm32LevelX::Driver;
+
+static constexpr int ROUNDS = 6;
+
+class TestDriver : public Stm32F4FlashDriver {
+public:
+    using Stm32F4FlashDriver::Stm32F4FlashDriver;
+
+    UINT eraseSector(const uint32_t addr, const ULONG erase_count) override {
+        erases++;
+        return Stm32F4FlashDriver::eraseSector(addr, erase_count);
+    }
+
+    uint32_t erases = 0;
+};
+
+struct Range {
+    uint8_t firstSector;
+    uint8_t sectorCount;
+    ULONG blockSize;
+    ULONG blocks;
+};
+
+static ULONG pattern(const ULONG sector, const unsigned i, const int round) {
+    return sector * 7 + i + round;
+}
+
+static void checkSectors(LevelXNorFlash &lx, const ULONG sectors) {
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (ULONG s = 0; s < sectors; s++) {
+        CHECK(lx.sectorRead(s, buffer) == LevelXErrorCode::SUCCESS);
+        for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) CHECK(buffer[i] == pattern(s, i, ROUNDS - 1));
+    }
+}
+
+static void checkRange(const Range &range) {
+    const uint32_t size = Stm32F4FlashDriver::getFlashSectorOffset(range.firstSector + range.sectorCount) -
+                          Stm32F4FlashDriver::getFlashSectorOffset(range.firstSector);
+    std::vector<uint8_t> memory(size, 0x00);
+    TestDriver driver(range.firstSector, range.sectorCount, memory.data());
+
+    const bool valid = range.blocks > 0;
+    CHECK((driver.initialize() == LX_SUCCESS) == valid);
+    std::printf("sectors %u..%u: ", range.firstSector, range.firstSector + range.sectorCount - 1);
+    if (!valid) {
+        std::printf("rejected\n");
+        return;
+    }
+    CHECK(driver.getSectorSize() == range.blockSize);
+    CHECK(driver.getTotalSectors() == range.blocks);
+    CHECK(driver.getBaseAddress() == reinterpret_cast<ULONG *>(memory.data()));
+
+    LevelXNorFlash lx(&driver);
+    CHECK(lx.format() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+
+    const uint32_t formatErases = driver.erases;
+    const ULONG sectors = lx.lx_nor_flash_free_physical_sectors / 2;
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (int round = 0; round < ROUNDS; round++) {
+        for (ULONG s = 0; s < sectors; s++) {
+            for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) buffer[i] = pattern(s, i, round);
+            CHECK(lx.sectorWrite(s, buffer) == LevelXErrorCode::SUCCESS);
+        }
+    }
+    CHECK(driver.erases > formatErases);
+    checkSectors(lx, sectors);
+
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+    checkSectors(lx, sectors);
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+
+    std::printf("%u x %u KB, %u logical sectors, %u erases\n", static_cast<unsigned>(range.blocks),
+                static_cast<unsigned>(range.blockSize / 1024), static_cast<unsigned>(sectors),
+                static_cast<unsigned>(driver.erases - formatErases));
+}
+
+int main() {
+    const Range ranges[] = {
+        {5, 7, 128 * 1024, 7},
+        {0, 5, 64 * 1024, 2},
+        {1, 3, 16 * 1024, 3},
+        {0, 12, 128 * 1024, 8},
+        // 3 x 16 KB and 64 KB do not make 64 KB blocks
+        {1, 4, 0, 0},
+        // 2 x 128 KB and 2 x 16 KB of bank 2 do not make 128 KB blocks
+        {10, 4, 0, 0},
+        // A single block leaves LevelX no room to reclaim
+        {4, 1, 0, 0},
+    };
+    for (const auto &range: ranges) checkRange(range);
+    return EXIT_SUCCESS;
+}
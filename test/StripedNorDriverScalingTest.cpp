@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Throughput of the StripedNorDriver over 1, 2 and 4 simulated SST26 devices, in simulated time.
+ *
+ * Measures raw block erases, raw page programs and LevelX sector writes, checks the data and the device
+ * protocol, and checks that the throughput grows with the number of devices: erases and programs run on
+ * all devices in parallel, LevelX sector writes are bound by the per-sector overhead of LevelX.
+ */
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Test.hpp"
+#include "LevelXNorFlash.hpp"
+#include "Driver/Sst26Driver.hpp"
+#include "Driver/StripedNorDriver.hpp"
+#include "Driver/Transport/SimulatedSpiTransport.hpp"
+
+using namespace Stm32LevelX;
+using namespace Stm32LevelX::Driver;
+
+static constexpr uint32_t DEVICE_SIZE = 2 * 1024 * 1024;
+static constexpr uint32_t RAW_BLOCKS = 64;
+static constexpr uint32_t PAGE_CHUNK = 4096;
+static constexpr ULONG LEVELX_SECTORS = 2000;
+static constexpr int LEVELX_ROUNDS = 3;
+
+struct Throughput {
+    double erase;
+    double program;
+    double levelx;
+};
+
+static double kbPerSecond(const uint64_t bytes, const uint64_t ns) {
+    return static_cast<double>(bytes) / (static_cast<double>(ns) / 1e9) / 1024;
+}
+
+static ULONG pattern(const ULONG sector, const unsigned i, const int round) {
+    return sector + i + round;
+}
+
+static void checkSectors(LevelXNorFlash &lx) {
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    for (ULONG s = 0; s < LEVELX_SECTORS; s++) {
+        CHECK(lx.sectorRead(s, buffer) == LevelXErrorCode::SUCCESS);
+        for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) CHECK(buffer[i] == pattern(s, i, LEVELX_ROUNDS - 1));
+    }
+}
+
+static Throughput measure(const uint8_t devices) {
+    VirtualClock clock;
+    std::vector<std::vector<uint8_t> > memory(devices, std::vector<uint8_t>(DEVICE_SIZE));
+    std::vector<std::unique_ptr<SimulatedSpiTransport> > transports;
+    std::vector<std::unique_ptr<Sst26Driver> > drivers;
+    AbstractNorDriver *stripes[StripedNorDriver::MAX_DRIVERS];
+    for (uint8_t i = 0; i < devices; i++) {
+        transports.emplace_back(new SimulatedSpiTransport(memory[i].data(), memory[i].size(), &clock));
+        transports[i]->format();
+        drivers.emplace_back(new Sst26Driver(transports[i].get()));
+        stripes[i] = drivers[i].get();
+    }
+    StripedNorDriver striped(stripes, devices);
+    CHECK(striped.initialize() == LX_SUCCESS);
+    const uint32_t blockSize = striped.getSectorSize();
+    Throughput result{};
+
+    uint64_t start = clock.now();
+    for (uint32_t b = 0; b < RAW_BLOCKS; b++) CHECK(striped.eraseSector(b * blockSize, 0) == LX_SUCCESS);
+    result.erase = kbPerSecond(static_cast<uint64_t>(RAW_BLOCKS) * blockSize, clock.now() - start);
+
+    std::vector<uint8_t> data(blockSize);
+    for (uint32_t i = 0; i < blockSize; i++) data[i] = static_cast<uint8_t>(i * 13 + 7);
+    start = clock.now();
+    for (uint32_t b = 0; b < RAW_BLOCKS; b++) {
+        for (uint32_t offset = 0; offset < blockSize; offset += PAGE_CHUNK) {
+            CHECK(striped.write(b * blockSize + offset, &data[offset], PAGE_CHUNK) == LX_SUCCESS);
+        }
+    }
+    result.program = kbPerSecond(static_cast<uint64_t>(RAW_BLOCKS) * blockSize, clock.now() - start);
+
+    std::vector<uint8_t> readBack(blockSize);
+    for (uint32_t b = 0; b < RAW_BLOCKS; b += 7) {
+        CHECK(striped.read(b * blockSize, readBack.data(), blockSize) == LX_SUCCESS);
+        CHECK(std::memcmp(readBack.data(), data.data(), blockSize) == 0);
+    }
+
+    for (auto &transport: transports) transport->format();
+    LevelXNorFlash lx(&striped);
+    CHECK(lx.format() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+    ULONG buffer[LX_NOR_SECTOR_SIZE];
+    start = clock.now();
+    for (int round = 0; round < LEVELX_ROUNDS; round++) {
+        for (ULONG s = 0; s < LEVELX_SECTORS; s++) {
+            for (unsigned i = 0; i < LX_NOR_SECTOR_SIZE; i++) buffer[i] = pattern(s, i, round);
+            CHECK(lx.sectorWrite(s, buffer) == LevelXErrorCode::SUCCESS);
+        }
+    }
+    result.levelx = kbPerSecond(static_cast<uint64_t>(LEVELX_ROUNDS) * LEVELX_SECTORS * LX_NOR_SECTOR_SIZE *
+                                sizeof(ULONG), clock.now() - start);
+    checkSectors(lx);
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.initialize() == LevelXErrorCode::SUCCESS);
+    CHECK(lx.open() == LevelXErrorCode::SUCCESS);
+    checkSectors(lx);
+    CHECK(lx.close() == LevelXErrorCode::SUCCESS);
+
+    for (auto &transport: transports) {
+        const auto &counters = transport->getCounters();
+        CHECK(counters.busyViolations == 0);
+        CHECK(counters.clockViolations == 0);
+        CHECK(counters.encodingErrors == 0);
+        CHECK(counters.rejectedWrites == 0);
+    }
+    return result;
+}
+
+int main() {
+    Throughput single{};
+    for (const uint8_t devices: {1, 2, 4}) {
+        const Throughput t = measure(devices);
+        if (devices == 1) single = t;
+        std::printf("%u devices: erase %.0f KB/s (x%.2f), program %.0f KB/s (x%.2f), LevelX write %.0f KB/s (x%.2f)\n",
+                    devices, t.erase, t.erase / single.erase, t.program, t.program / single.program,
+                    t.levelx, t.levelx / single.levelx);
+
+        // Raw erases and programs scale almost linearly, LevelX has to gain at least something
+        CHECK(t.erase >= 0.9 * devices * single.erase);
+        CHECK(t.program >= 0.9 * devices * single.program);
+        if (devices > 1) CHECK(t.levelx > 1.2 * single.levelx);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Minimal checks for the host tests. A failed check prints the location and the condition and ends the
+ * test with a non-zero exit code, which ctest reports as a failure.
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_TEST_HPP
+#define LIBSMART_STM32LEVELX_TEST_TEST_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#endif //LIBSMART_STM32LEVELX_TEST_TEST_HPP
@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_LOGGABLE_HPP
+#define LIBSMART_STM32LEVELX_TEST_LOGGABLE_HPP
+
+#include "Stm32ItmLogger.hpp"
+
+#endif //LIBSMART_STM32LEVELX_TEST_LOGGABLE_HPP
@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_NAMEABLE_HPP
+#define LIBSMART_STM32LEVELX_TEST_NAMEABLE_HPP
+
+namespace Stm32Common {
+    class Nameable {
+    public:
+        Nameable() = default;
+
+        explicit Nameable(const char *name) : name(name) {}
+
+        [[nodiscard]] const char *getName() const { return name; }
+
+        void setName(const char *newName) { name = newName; }
+
+    private:
+        const char *name = "";
+    };
+}
+
+#endif //LIBSMART_STM32LEVELX_TEST_NAMEABLE_HPP
@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host replacement for the parts of libsmart/Stm32Common used by the library.
+ *
+ * millis() and delay() do not touch a real clock. A test can install hooks to drive them from a
+ * Driver::VirtualClock or to run code while a driver waits for the flash.
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_STM32COMMON_HPP
+#define LIBSMART_STM32LEVELX_TEST_STM32COMMON_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Stm32Common {
+    enum class HalStatus : uint8_t {
+        HAL_OK = 0x00U,
+        HAL_ERROR = 0x01U,
+        HAL_BUSY = 0x02U,
+        HAL_TIMEOUT = 0x03U
+    };
+}
+
+inline uint32_t (*millisHook)() = nullptr;
+inline void (*delayHook)() = nullptr;
+
+inline uint32_t millis() { return millisHook != nullptr ? millisHook() : 0; }
+
+inline void delay(uint32_t) { if (delayHook != nullptr) delayHook(); }
+
+#ifndef UNUSED
+#define UNUSED(X) (void)X
+#endif
+
+#endif //LIBSMART_STM32LEVELX_TEST_STM32COMMON_HPP
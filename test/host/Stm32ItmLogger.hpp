@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host replacement for libsmart/Stm32ItmLogger. Log output is discarded.
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_STM32ITMLOGGER_HPP
+#define LIBSMART_STM32LEVELX_TEST_STM32ITMLOGGER_HPP
+
+#include <cstddef>
+
+namespace Stm32ItmLogger {
+    class LoggerInterface {
+    public:
+        enum class Severity { EMERGENCY, ALERT, CRITICAL, ERROR, WARNING, NOTICE, INFORMATIONAL, DEBUG };
+
+        virtual ~LoggerInterface() = default;
+
+        virtual LoggerInterface *setSeverity(Severity) { return this; }
+
+        virtual size_t printf(const char *, ...) { return 0; }
+
+        virtual size_t println(const char * = "") { return 0; }
+
+        virtual size_t print(const char *) { return 0; }
+    };
+
+    class Stm32ItmLogger : public LoggerInterface {
+    };
+
+    inline Stm32ItmLogger logger;
+
+    class Loggable {
+    public:
+        Loggable() = default;
+
+        explicit Loggable(LoggerInterface *logger) : logger(logger) {}
+
+        LoggerInterface *log() { return logger != nullptr ? logger : &nullLogger; }
+
+        void setLogger(LoggerInterface *newLogger) { logger = newLogger; }
+
+    protected:
+        LoggerInterface *logger = nullptr;
+
+    private:
+        inline static LoggerInterface nullLogger;
+    };
+}
+
+#endif //LIBSMART_STM32LEVELX_TEST_STM32ITMLOGGER_HPP
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * LevelX basic types for the host build.
+ *
+ * LevelX assumes that ULONG is 32 bits wide (the Cortex-M port of ThreadX). Without ThreadX, lx_api.h
+ * defines ULONG as unsigned long, which is 64 bits wide on a 64 bit host. This file is force included
+ * before lx_api.h and defines the types the way the target does.
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_LX_HOST_PORT_H
+#define LIBSMART_STM32LEVELX_TEST_LX_HOST_PORT_H
+
+#define VOID                                    void
+typedef char                                    CHAR;
+typedef char                                    BOOL;
+typedef unsigned char                           UCHAR;
+typedef int                                     INT;
+typedef unsigned int                            UINT;
+typedef int                                     LONG;
+typedef unsigned int                            ULONG;
+typedef short                                   SHORT;
+typedef unsigned short                          USHORT;
+
+#endif //LIBSMART_STM32LEVELX_TEST_LX_HOST_PORT_H
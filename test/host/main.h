@@ -0,0 +1,17 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host replacement for the main.h of the STM32CubeMX project. No HAL module is enabled, so the drivers
+ * build in their simulated or software variants.
+ */
+
+#ifndef LIBSMART_STM32LEVELX_TEST_MAIN_H
+#define LIBSMART_STM32LEVELX_TEST_MAIN_H
+
+#include <stdint.h>
+#include "Stm32Common.hpp"
+
+#endif //LIBSMART_STM32LEVELX_TEST_MAIN_H